@@ -0,0 +1,49 @@
+#ifndef __AFFINE_LIKELIHOOD_H__
+#define __AFFINE_LIKELIHOOD_H__
+
+#include <cmath>
+
+namespace CAROL {
+
+// Modelo de 4 parâmetros (u = a + c*x - d*y, v = b + d*x + c*y) ajustado por mínimos quadrados aos
+// vetores translacionais dos quatro quadrantes de um CU (centros em (+-w/4, +-h/4) do centro do CU).
+// O erro da translação pura (desvio dos vetores em relação à média) se decompõe em affinePart, o que
+// o modelo afim explicaria, e residual, o que nem ele explica; ambos em RMS de amostras.
+struct AffineLikelihood {
+    double affinePart = 0;
+    double residual   = 0;
+
+    // mvHor/mvVer em amostras, quadrantes na ordem superior esquerdo, superior direito, inferior esquerdo, inferior direito
+    static AffineLikelihood fit(const int mvHor[4], const int mvVer[4], int width, int height) {
+        const double qx   = width / 4.0;
+        const double qy   = height / 4.0;
+        const double x[4] = { -qx, qx, -qx, qx };
+        const double y[4] = { -qy, -qy, qy, qy };
+
+        const double a = (mvHor[0] + mvHor[1] + mvHor[2] + mvHor[3]) / 4.0;
+        const double b = (mvVer[0] + mvVer[1] + mvVer[2] + mvVer[3]) / 4.0;
+        double sumC = 0, sumD = 0;
+        for (int i = 0; i < 4; i++) {
+            sumC += (mvHor[i] - a) * x[i] + (mvVer[i] - b) * y[i];
+            sumD += (mvVer[i] - b) * x[i] - (mvHor[i] - a) * y[i];
+        }
+        const double norm = 4 * (qx * qx + qy * qy);
+        const double c    = sumC / norm;
+        const double d    = sumD / norm;
+
+        AffineLikelihood result;
+        result.affinePart = std::sqrt((c * c + d * d) * (qx * qx + qy * qy));
+        double sumRes = 0;
+        for (int i = 0; i < 4; i++) {
+            const double du = mvHor[i] - (a + c * x[i] - d * y[i]);
+            const double dv = mvVer[i] - (b + d * x[i] + c * y[i]);
+            sumRes += du * du + dv * dv;
+        }
+        result.residual = std::sqrt(sumRes / 4);
+        return result;
+    }
+};
+
+}
+
+#endif
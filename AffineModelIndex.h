@@ -0,0 +1,109 @@
+#ifndef __AFFINE_MODEL_INDEX_H__
+#define __AFFINE_MODEL_INDEX_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CommonLib/Mv.h"
+#include "CtuScope.h"
+#include <algorithm>
+#include <vector>
+
+namespace CAROL {
+
+// Modelos afins de 4 parâmetros já estimados na CTU, em grade 8x8 por (lista, refIdx): cada célula
+// aponta para o modelo mais recente de um bloco que a cobre. Um novo CU (de qualquer tamanho) consulta
+// diretamente os modelos dos blocos sobrepostos ou que o contêm, sem varrer o m_affMVList.
+class AffineModelIndex {
+public:
+    static const int GRID_LOG2  = 3;
+    static const int MAX_MODELS = 4;
+
+    struct Model {
+        int x = 0;
+        int y = 0;
+        int w = 0;
+        int h = 0;
+        Mv  mv[2];      // vetores de controle superior esquerdo e superior direito do bloco de origem
+    };
+
+    // Limpa o índice ao mudar de CTU
+    void enterCtu(const CtuTag& tag, int ctuSize) {
+        if (tag != m_ctu || ctuSize != m_ctuSize) {
+            m_ctu      = tag;
+            m_ctuSize  = ctuSize;
+            m_gridSize = ctuSize >> GRID_LOG2;
+            m_cells.assign((size_t)NUM_REF_PIC_LIST_01 * MAX_NUM_REF * m_gridSize * m_gridSize, -1);
+            m_models.clear();
+        }
+    }
+
+    // Modelos distintos das células cobertas pelo bloco, do mais recente ao mais antigo
+    int lookup(int list, int refIdx, const Area& blk, Model models[MAX_MODELS]) const {
+        int found[MAX_MODELS];
+        int numModels = 0;
+        xForEachCell(list, refIdx, blk, [&](int index) {
+            if (index < 0 || std::find(found, found + numModels, index) != found + numModels) return;
+            if (numModels < MAX_MODELS) {
+                found[numModels++] = index;
+            } else {
+                // mantém os mais recentes
+                int* oldest = std::min_element(found, found + numModels);
+                if (index > *oldest) *oldest = index;
+            }
+        });
+        std::sort(found, found + numModels, [](int a, int b) { return a > b; });
+        for (int i = 0; i < numModels; i++) {
+            models[i] = m_models[found[i]];
+        }
+        return numModels;
+    }
+
+    // Registra o modelo convergido do bloco nas células que ele cobre
+    void store(int list, int refIdx, const Area& blk, const Mv mv[2]) {
+        Model model;
+        model.x     = blk.x;
+        model.y     = blk.y;
+        model.w     = blk.width;
+        model.h     = blk.height;
+        model.mv[0] = mv[0];
+        model.mv[1] = mv[1];
+        const int index = (int)m_models.size();
+        m_models.push_back(model);
+        xForEachCell(list, refIdx, blk, [&](int& cell) { cell = index; });
+    }
+
+private:
+    template<typename CellT, typename Func>
+    static void xForEachCell(CellT* cells, int gridSize, int ctuX0, int ctuY0, const Area& blk, Func func) {
+        const int x0 = std::max(0, (blk.x - ctuX0) >> GRID_LOG2);
+        const int y0 = std::max(0, (blk.y - ctuY0) >> GRID_LOG2);
+        const int x1 = std::min(gridSize, (int)((blk.x + blk.width - ctuX0 + 7) >> GRID_LOG2));
+        const int y1 = std::min(gridSize, (int)((blk.y + blk.height - ctuY0 + 7) >> GRID_LOG2));
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                func(cells[y * gridSize + x]);
+            }
+        }
+    }
+
+    template<typename Func>
+    void xForEachCell(int list, int refIdx, const Area& blk, Func func) const {
+        xForEachCell(xCells(list, refIdx), m_gridSize, m_ctu.ctuX * m_ctuSize, m_ctu.ctuY * m_ctuSize, blk, func);
+    }
+    template<typename Func>
+    void xForEachCell(int list, int refIdx, const Area& blk, Func func) {
+        xForEachCell(xCells(list, refIdx), m_gridSize, m_ctu.ctuX * m_ctuSize, m_ctu.ctuY * m_ctuSize, blk, func);
+    }
+
+    const int* xCells(int list, int refIdx) const { return m_cells.data() + (size_t)(list * MAX_NUM_REF + refIdx) * m_gridSize * m_gridSize; }
+    int*       xCells(int list, int refIdx)       { return m_cells.data() + (size_t)(list * MAX_NUM_REF + refIdx) * m_gridSize * m_gridSize; }
+
+    CtuTag             m_ctu;
+    int                m_ctuSize  = 0;
+    int                m_gridSize = 0;
+    std::vector<int>   m_cells;     // índice em m_models, -1: vazia
+    std::vector<Model> m_models;    // modelos da CTU na ordem de inserção
+};
+
+}
+
+#endif
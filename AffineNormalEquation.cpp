@@ -0,0 +1,145 @@
+#include "AffineNormalEquation.h"
+
+#include <algorithm>
+
+#if ENABLE_SIMD_OPT && defined(__GNUC__) && defined(__x86_64__)
+#define CAROL_AFFINE_SSE41 1
+#include <smmintrin.h>
+#else
+#define CAROL_AFFINE_SSE41 0
+#endif
+
+namespace CAROL {
+
+static const int MAX_PARAMS = 6;
+static const int NUM_PRODUCTS = MAX_PARAMS * (MAX_PARAMS + 1) / 2 + MAX_PARAMS;   // triângulo + resíduo
+
+// Parâmetros iC de cada amostra de uma linha e o resíduo
+struct AffineRow {
+    int c[MAX_PARAMS][MAX_CU_SIZE];
+    int res[MAX_CU_SIZE];
+};
+
+static void xFillRow(const Pel* org, ptrdiff_t orgStride, const Pel* pred, ptrdiff_t predStride, int width, int height,
+                     int j, bool sixParam, AffineRow& row) {
+    // a linha j usa o Sobel da linha interna mais próxima (bordas replicadas)
+    const int  jc    = std::min(std::max(j, 1), height - 2);
+    const Pel* above = pred + (jc - 1) * predStride;
+    const Pel* cur   = pred + jc * predStride;
+    const Pel* below = pred + (jc + 1) * predStride;
+    const Pel* o     = org + j * orgStride;
+    const Pel* p     = pred + j * predStride;
+    const int  cy    = ((j >> 2) << 2) + 2;
+
+    for (int k = 0; k < width; k++) {
+        const int kc = std::min(std::max(k, 1), width - 2);
+        const int gx = above[kc + 1] - above[kc - 1] + 2 * (cur[kc + 1] - cur[kc - 1]) + below[kc + 1] - below[kc - 1];
+        const int gy = below[kc - 1] - above[kc - 1] + 2 * (below[kc] - above[kc]) + below[kc + 1] - above[kc + 1];
+        const int cx = ((k >> 2) << 2) + 2;
+
+        if (sixParam) {
+            row.c[0][k] = gx;
+            row.c[1][k] = cx * gx;
+            row.c[2][k] = gy;
+            row.c[3][k] = cx * gy;
+            row.c[4][k] = cy * gx;
+            row.c[5][k] = cy * gy;
+        } else {
+            row.c[0][k] = gx;
+            row.c[1][k] = cx * gx + cy * gy;
+            row.c[2][k] = gy;
+            row.c[3][k] = cy * gx - cx * gy;
+        }
+        row.res[k] = o[k] - p[k];
+    }
+}
+
+static void xAccumulateScalar(const AffineRow& row, int k0, int width, int numParams, int64_t* acc) {
+    for (int k = k0; k < width; k++) {
+        int idx = 0;
+        for (int col = 0; col < numParams; col++) {
+            for (int r = 0; r <= col; r++) {
+                acc[idx++] += (int64_t)row.c[col][k] * row.c[r][k];
+            }
+            acc[idx++] += (int64_t)row.c[col][k] * row.res[k];
+        }
+    }
+}
+
+#if CAROL_AFFINE_SSE41
+// 4 amostras por vez; _mm_mul_epi32 multiplica as faixas pares, as ímpares vêm deslocadas de 32 bits
+__attribute__((target("sse4.1")))
+static int xAccumulateSse41(const AffineRow& row, int width, int numParams, int64_t* acc) {
+    __m128i sum[NUM_PRODUCTS];
+    for (int i = 0; i < NUM_PRODUCTS; i++) {
+        sum[i] = _mm_setzero_si128();
+    }
+
+    int k = 0;
+    for (; k + 4 <= width; k += 4) {
+        __m128i c[MAX_PARAMS + 1];
+        for (int p = 0; p < numParams; p++) {
+            c[p] = _mm_loadu_si128((const __m128i*)(row.c[p] + k));
+        }
+        const __m128i res = _mm_loadu_si128((const __m128i*)(row.res + k));
+
+        int idx = 0;
+        for (int col = 0; col < numParams; col++) {
+            const __m128i a    = c[col];
+            const __m128i aOdd = _mm_srli_epi64(a, 32);
+            for (int r = 0; r <= col; r++) {
+                const __m128i even = _mm_mul_epi32(a, c[r]);
+                const __m128i odd  = _mm_mul_epi32(aOdd, _mm_srli_epi64(c[r], 32));
+                sum[idx] = _mm_add_epi64(sum[idx], _mm_add_epi64(even, odd));
+                idx++;
+            }
+            const __m128i even = _mm_mul_epi32(a, res);
+            const __m128i odd  = _mm_mul_epi32(aOdd, _mm_srli_epi64(res, 32));
+            sum[idx] = _mm_add_epi64(sum[idx], _mm_add_epi64(even, odd));
+            idx++;
+        }
+    }
+
+    const int numProducts = numParams * (numParams + 1) / 2 + numParams;
+    for (int i = 0; i < numProducts; i++) {
+        acc[i] += _mm_cvtsi128_si64(sum[i]) + _mm_extract_epi64(sum[i], 1);
+    }
+    return k;
+}
+#endif
+
+void accumulateAffineNormalEquation(const Pel* org, ptrdiff_t orgStride, const Pel* pred, ptrdiff_t predStride,
+                                    int width, int height, int rowStep, bool sixParam, int64_t coeff[7][7]) {
+    const int numParams = sixParam ? 6 : 4;
+#if CAROL_AFFINE_SSE41
+    static const bool useSse41 = __builtin_cpu_supports("sse4.1");
+#endif
+
+    AffineRow row;
+    int64_t   acc[NUM_PRODUCTS] = { 0 };
+    for (int j = 0; j < height; j += rowStep) {
+        xFillRow(org, orgStride, pred, predStride, width, height, j, sixParam, row);
+        int k0 = 0;
+#if CAROL_AFFINE_SSE41
+        if (useSse41) {
+            k0 = xAccumulateSse41(row, width, numParams, acc);
+        }
+#endif
+        xAccumulateScalar(row, k0, width, numParams, acc);
+    }
+
+    // triângulo inferior espelhado; o termo do resíduo leva o << 3 do m_EqualCoeffComputer
+    int idx = 0;
+    for (int col = 0; col < numParams; col++) {
+        for (int r = 0; r <= col; r++) {
+            coeff[col + 1][r] += acc[idx];
+            if (r != col) {
+                coeff[r + 1][col] += acc[idx];
+            }
+            idx++;
+        }
+        coeff[col + 1][numParams] += acc[idx++] * 8;
+    }
+}
+
+}
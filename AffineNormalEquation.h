@@ -0,0 +1,21 @@
+#ifndef __AFFINE_NORMAL_EQUATION_H__
+#define __AFFINE_NORMAL_EQUATION_H__
+
+#include "CommonLib/CommonDef.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace CAROL {
+
+// Equações normais do Gauss-Newton afim numa única passada pelo bloco: o resíduo (org - pred),
+// os gradientes Sobel horizontal/vertical (bordas replicadas) e os produtos iC[col] * iC[row] e
+// iC[col] * resíduo são calculados linha a linha, sem os buffers m_tmpAffiError/m_tmpAffiDeri.
+// Soma em coeff o mesmo que m_HorizontalSobelFilter + m_VerticalSobelFilter + m_EqualCoeffComputer
+// (coeff[col + 1][row]), usando só as linhas múltiplas de rowStep (1: bit-exato; 2: meia resolução).
+// A acumulação usa SSE4.1 quando a CPU suporta.
+void accumulateAffineNormalEquation(const Pel* org, ptrdiff_t orgStride, const Pel* pred, ptrdiff_t predStride,
+                                    int width, int height, int rowStep, bool sixParam, int64_t coeff[7][7]);
+
+}
+
+#endif
@@ -19,6 +19,12 @@ config_videos_base = os.path.join(diretorio_base, "cfg/per-sequence")
 videos = ["BasketballPass"]
 qps = [22, 27, 32, 37]
 
+# Modo multi-QP: um único processo por vídeo codifica todos os QPs (--CAROLQPs), em sequência;
+# bitstreams, reconstruções e CSVs saem com sufixo _qpN. Desligado por padrão: o cfg de random access
+# liga o TemporalFilter, então nada é compartilhado entre os QPs (nem as features do original, nem a
+# leitura do YUV e o filtro temporal) e os QPs deixam de rodar em paralelo nos NUCLEOS
+MULTI_QP = False
+
 
 # =======================
 # FUNÇÕES AUXILIARES
@@ -68,6 +74,45 @@ def executar_coding(args):
         return f"[ERRO] {nome_video} | QP={qp} | Erro: {e}"
 
 
+def executar_coding_multi_qp(args):
+    """Todos os QPs de um vídeo num só processo do encoder."""
+    nome_video, lista_qps, frames, caminho_cfg, diretorio_video = args
+
+    diretorio_logs = os.path.join(diretorio_video, "logs")
+    diretorio_yuvs = os.path.join(diretorio_video, "yuvs")
+    diretorio_bins = os.path.join(diretorio_video, "bins")
+    os.makedirs(diretorio_logs, exist_ok=True)
+    os.makedirs(diretorio_yuvs, exist_ok=True)
+    os.makedirs(diretorio_bins, exist_ok=True)
+
+    # o encoder acrescenta _qpN antes da extensão: <video>_qp22.yuv, <video>_qp22.bin...
+    caminho_saida_yuv = os.path.join(diretorio_yuvs, f"{nome_video}.yuv")
+    caminho_saida_bin = os.path.join(diretorio_bins, f"{nome_video}.bin")
+    caminho_saida_log = os.path.join(diretorio_logs, f"{nome_video}_multiqp.log")
+    qps_str = ",".join(str(qp) for qp in lista_qps)
+
+    comando = (
+        f"./bin/EncoderAppStatic "
+        f"-c {config_randomaccess} "
+        f"-c {caminho_cfg} "
+        f"-f {frames} "
+        f"-b {caminho_saida_bin} "
+        f"-o {caminho_saida_yuv} "
+        f"--CAROLQPs={qps_str} > {caminho_saida_log}"
+    )
+
+    try:
+        subprocess.run(
+            comando,
+            shell=True,
+            cwd=diretorio_base,
+            check=True
+        )
+        return f"[OK] {nome_video} | QPs={qps_str} | Frames={frames}"
+    except subprocess.CalledProcessError as e:
+        return f"[ERRO] {nome_video} | QPs={qps_str} | Erro: {e}"
+
+
 # =======================
 # SCRIPT PRINCIPAL
 # =======================
@@ -108,15 +153,19 @@ def codificar_videos():
         diretorio_video = os.path.join(diretorio_resultados, nome_video)
         os.makedirs(diretorio_video, exist_ok=True)
 
-        for qp in qps:
-            tarefas.append((nome_video, qp, frames, caminho_cfg, diretorio_video))
+        if MULTI_QP:
+            tarefas.append((nome_video, qps, frames, caminho_cfg, diretorio_video))
+        else:
+            for qp in qps:
+                tarefas.append((nome_video, qp, frames, caminho_cfg, diretorio_video))
 
     print(f"\nIniciando paralelização usando {NUM_NUCLEOS} núcleos: {NUCLEOS}")
     print(f"Total de tarefas: {len(tarefas)}\n")
 
     # EXECUÇÃO PARALELA
     with ProcessPoolExecutor(max_workers=NUM_NUCLEOS) as executor:
-        futuros = {executor.submit(executar_coding, t): t for t in tarefas}
+        funcao = executar_coding_multi_qp if MULTI_QP else executar_coding
+        futuros = {executor.submit(funcao, t): t for t in tarefas}
 
         for futuro in as_completed(futuros):
             print(futuro.result())
@@ -6,6 +6,7 @@
 #include <cmath>
 
 #include "BlockFeatures.h"
+#include "HotPathProfiler.h"
 
 // =======================================================
 // 1D Fast Walsh-Hadamard Transform (in-place)
@@ -224,8 +225,9 @@ inline ResidualFeatures calculate_residual_features(const cv::Mat& resi)
 // =======================================================
 // MAIN EXTRACTION
 // =======================================================
-BlockFeatures extract_block_features(const cv::Mat& blk, const cv::Mat& resi)
+BlockFeatures extract_org_features(const cv::Mat& blk)
 {
+    CAROL_SCOPED_TIMER(EXTRACT_BLOCK_FEATURES);
     BlockFeatures f{};
     auto [mean,var,std_dev,sum_val] = calculate_basic_features_cv(blk);
     f.blk_pixel_mean = mean; f.blk_pixel_variance = var; f.blk_pixel_std_dev = std_dev; f.blk_pixel_sum = sum_val;
@@ -246,9 +248,20 @@ BlockFeatures extract_block_features(const cv::Mat& blk, const cv::Mat& resi)
     f.blk_entropy = calculate_entropy_cv(blk);
 
     f.hadamard = calculate_hadamard_features(blk);
+    return f;
+}
+
+ResidualFeatures extract_residual_features(const cv::Mat& resi)
+{
+    return calculate_residual_features(resi);
+}
+
+BlockFeatures extract_block_features(const cv::Mat& blk, const cv::Mat& resi)
+{
+    BlockFeatures f = extract_org_features(blk);
 
     // Extração das novas features de resíduo
-    f.residual = calculate_residual_features(resi);
+    f.residual = extract_residual_features(resi);
     return f;
 }
 
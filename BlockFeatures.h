@@ -58,6 +58,10 @@ struct BlockFeatures {
 };
 
 BlockFeatures extract_block_features(const cv::Mat& blk, const cv::Mat& resi);
+
+// Partes separadas: as features do bloco original não dependem do QP (o campo residual fica zerado)
+BlockFeatures    extract_org_features(const cv::Mat& blk);
+ResidualFeatures extract_residual_features(const cv::Mat& resi);
 void print_features(const BlockFeatures& f);
 
 #endif // __BLOCK_FEATURES_H__
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "BlockHistogram.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace CAROL {
+
+static const char* g_funcNames[(int)BlockFunc::NUM] = { "predInterSearch", "xEstimateInterResidualQT" };
+static const char* g_modeNames[(int)BlockMode::NUM] = { "merge", "AMVP", "affine", "IBC", "hash" };
+
+static const char* mtsName(int mts) {
+    switch ((MtsType)mts) {
+        case MtsType::DCT2_DCT2: return "DCT2_DCT2";
+        case MtsType::SKIP:      return "SKIP";
+        case MtsType::DST7_DST7: return "DST7_DST7";
+        case MtsType::DCT8_DST7: return "DCT8_DST7";
+        case MtsType::DST7_DCT8: return "DST7_DCT8";
+        case MtsType::DCT8_DCT8: return "DCT8_DCT8";
+        default:                 return "-";
+    }
+}
+
+// Chave empacotada: função (1 bit) | modo (3) | mts (4) | W-1 (8) | H-1 (8)
+static inline uint32_t packKey(BlockFunc func, int w, int h, BlockMode mode, MtsType mts) {
+    return ((uint32_t)func << 23) | ((uint32_t)mode << 20) | (((uint32_t)mts & 0xf) << 16)
+         | ((uint32_t)(w - 1) << 8) | (uint32_t)(h - 1);
+}
+
+using BinMap = std::unordered_map<uint32_t, TimerCounter>;
+
+static std::mutex g_histMutex;
+static std::vector<std::unique_ptr<BinMap>> g_threadBins;
+
+void BlockHistogram::record(BlockFunc func, int width, int height, BlockMode mode, MtsType mtsIdx, uint64_t cycles) {
+    thread_local BinMap* bins = nullptr;
+    if (bins == nullptr) {
+        std::lock_guard<std::mutex> lock(g_histMutex);
+        g_threadBins.emplace_back(new BinMap);
+        bins = g_threadBins.back().get();
+    }
+    TimerCounter& bin = (*bins)[packKey(func, width, height, mode, mtsIdx)];
+    bin.calls++;
+    bin.cycles += cycles;
+}
+
+void BlockHistogram::write(const std::string& fileName) {
+    if (fileName.empty()) return;
+
+    // Junta as threads; std::map deixa a saída ordenada por função/modo/tamanho
+    std::map<uint32_t, TimerCounter> total;
+    {
+        std::lock_guard<std::mutex> lock(g_histMutex);
+        for (const auto& bins : g_threadBins) {
+            for (const auto& [key, bin] : *bins) {
+                total[key].calls  += bin.calls;
+                total[key].cycles += bin.cycles;
+            }
+        }
+    }
+
+    std::ofstream out(fileName);
+    if (!out.is_open()) return;
+
+    const bool json = fileName.size() >= 5 && fileName.compare(fileName.size() - 5, 5, ".json") == 0;
+    if (json) out << "[\n";
+    else      out << "Function,W,H,Mode,Mts,Calls,Cycles\n";
+
+    bool first = true;
+    for (const auto& [key, bin] : total) {
+        const char* func = g_funcNames[(key >> 23) & 0x1];
+        const char* mode = g_modeNames[(key >> 20) & 0x7];
+        const char* mts  = mtsName((key >> 16) & 0xf);
+        const int   w    = ((key >> 8) & 0xff) + 1;
+        const int   h    = (key & 0xff) + 1;
+        if (json) {
+            out << (first ? "" : ",\n") << "  { \"function\": \"" << func << "\", \"w\": " << w << ", \"h\": " << h
+                << ", \"mode\": \"" << mode << "\", \"mts\": \"" << mts << "\", \"calls\": " << bin.calls
+                << ", \"cycles\": " << bin.cycles << " }";
+        } else {
+            out << func << "," << w << "," << h << "," << mode << "," << mts << "," << bin.calls << "," << bin.cycles << "\n";
+        }
+        first = false;
+    }
+    if (json) out << "\n]\n";
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef __BLOCK_HISTOGRAM_H__
+#define __BLOCK_HISTOGRAM_H__
+
+// Histograma de chamadas e ciclos por (W, H, modo, MtsType) para predInterSearch e a QT de resíduo.
+// Faz parte da instrumentação do HotPathProfiler e só gera código com CAROL_PROFILING=1.
+#include "HotPathProfiler.h"
+#include "CommonLib/Unit.h"
+#include <string>
+
+namespace CAROL {
+
+enum class BlockFunc : int { PRED_INTER_SEARCH = 0, INTER_RESIDUAL_QT, NUM };
+
+enum class BlockMode : int { MERGE = 0, AMVP, AFFINE, IBC, HASH, NUM };
+
+class BlockHistogram {
+public:
+    static void record(BlockFunc func, int width, int height, BlockMode mode, MtsType mtsIdx, uint64_t cycles);
+
+    // Escreve a tabela em CSV, ou em JSON se o nome terminar com ".json" (ignorado se vazio)
+    static void write(const std::string& fileName);
+
+    static BlockMode modeOf(const CodingUnit& cu) {
+        if (cu.predMode == MODE_IBC) return BlockMode::IBC;
+        if (cu.firstPU && cu.firstPU->mergeFlag) return BlockMode::MERGE;
+        if (cu.affine) return BlockMode::AFFINE;
+        return BlockMode::AMVP;
+    }
+};
+
+// Mede o escopo e registra no histograma com o estado da CU na saída (modo e MTS escolhidos)
+class ScopedBlockTimer {
+public:
+    ScopedBlockTimer(BlockFunc func, const CodingUnit& cu, bool enabled = true, bool hashSearch = false)
+        : m_func(func), m_cu(cu), m_enabled(enabled), m_hashSearch(hashSearch)
+        , m_start(enabled ? HotPathProfiler::readCycles() : 0) {}
+
+    ~ScopedBlockTimer() {
+        if (!m_enabled) return;
+        const uint64_t cycles = HotPathProfiler::readCycles() - m_start;
+        const BlockMode mode  = m_hashSearch ? BlockMode::HASH : BlockHistogram::modeOf(m_cu);
+        const MtsType   mts   = m_func == BlockFunc::INTER_RESIDUAL_QT && m_cu.firstTU ? m_cu.firstTU->mtsIdx[COMPONENT_Y] : MtsType::NONE;
+        BlockHistogram::record(m_func, m_cu.lwidth(), m_cu.lheight(), mode, mts, cycles);
+    }
+
+    ScopedBlockTimer(const ScopedBlockTimer&) = delete;
+    void operator=(const ScopedBlockTimer&) = delete;
+
+private:
+    BlockFunc         m_func;
+    const CodingUnit& m_cu;
+    bool              m_enabled;
+    bool              m_hashSearch;
+    uint64_t          m_start;
+};
+
+}
+
+#if CAROL_PROFILING
+#define CAROL_BLOCK_TIMER(func, cu, ...) CAROL::ScopedBlockTimer CAROL_SCOPED_TIMER_CAT(carolBlkTimer_, __LINE__)(CAROL::BlockFunc::func, cu, ##__VA_ARGS__)
+#else
+#define CAROL_BLOCK_TIMER(func, cu, ...)
+#endif
+
+#endif
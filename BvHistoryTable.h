@@ -0,0 +1,150 @@
+#ifndef __BV_HISTORY_TABLE_H__
+#define __BV_HISTORY_TABLE_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CtuScope.h"
+#include <vector>
+
+namespace CAROL {
+
+// Histórico de vetores de bloco (IBC) da CTU: custo de cada (posição, tamanho, BV) já avaliado.
+// Substitui o m_ctuRecord (std::map de std::map de std::unordered_map): as entradas ficam num arena
+// contíguo, indexadas por endereçamento aberto na chave completa, e as de um mesmo bloco formam uma
+// lista encadeada por índice. Trocar de CTU só incrementa a geração, sem liberar memória.
+class BvHistoryTable {
+public:
+    BvHistoryTable() { xResize(INITIAL_LOG2_SLOTS); }
+
+    void enterCtu(const CtuTag& tag, int ctuSize) {
+        if (tag != m_ctu || ctuSize != m_ctuSize) {
+            m_ctu     = tag;
+            m_ctuSize = ctuSize;
+            xReset();
+        }
+    }
+
+    // Grava (ou substitui) o custo do BV (hor, ver) do bloco em pos/size
+    void record(const Position& pos, const Size& size, int hor, int ver, Distortion cost) {
+        const uint32_t blockKey = xBlockKey(pos, size);
+        const uint64_t key      = ((uint64_t)blockKey << 32) | ((uint64_t)(uint16_t)hor << 16) | (uint64_t)(uint16_t)ver;
+
+        uint32_t slot = xFindSlot(m_entrySlots, key);
+        if (m_entrySlots[slot].gen == m_gen) {
+            m_entries[m_entrySlots[slot].index].cost = cost;
+            return;
+        }
+
+        if (2 * (m_numEntries + 1) > m_entrySlots.size()) {
+            xResize(m_log2Slots + 1);
+            slot = xFindSlot(m_entrySlots, key);
+        }
+
+        const uint32_t blockSlot = xFindSlot(m_blockSlots, blockKey);
+        const int      head      = m_blockSlots[blockSlot].gen == m_gen ? m_blockSlots[blockSlot].index : -1;
+
+        if (m_numEntries == m_entries.size()) {
+            m_entries.emplace_back();
+        }
+        Entry& entry = m_entries[m_numEntries];
+        entry.key  = key;
+        entry.hor  = hor;
+        entry.ver  = ver;
+        entry.cost = cost;
+        entry.next = head;
+
+        m_entrySlots[slot]      = { m_gen, key, (int)m_numEntries };
+        m_blockSlots[blockSlot] = { m_gen, blockKey, (int)m_numEntries };
+        m_numEntries++;
+    }
+
+    // Chama func(hor, ver, cost) para cada BV gravado do bloco, do mais recente ao mais antigo
+    template<typename Func>
+    void forEach(const Position& pos, const Size& size, Func func) const {
+        const uint32_t blockKey  = xBlockKey(pos, size);
+        const uint32_t blockSlot = xFindSlot(m_blockSlots, blockKey);
+        if (m_blockSlots[blockSlot].gen != m_gen) {
+            return;
+        }
+        for (int i = m_blockSlots[blockSlot].index; i >= 0; i = m_entries[i].next) {
+            func(m_entries[i].hor, m_entries[i].ver, m_entries[i].cost);
+        }
+    }
+
+private:
+    static const int INITIAL_LOG2_SLOTS = 12;
+
+    struct Entry {
+        uint64_t   key;
+        int        hor;
+        int        ver;
+        Distortion cost;
+        int        next;    // entrada anterior do mesmo bloco, -1 no fim
+    };
+
+    struct Slot {
+        uint32_t gen;       // slot ocupado só se gen == m_gen
+        uint64_t key;
+        int      index;     // entrada em m_entries
+    };
+
+    // posição relativa à CTU (7 bits cada) e tamanho - 1 (7 bits cada)
+    uint32_t xBlockKey(const Position& pos, const Size& size) const {
+        const int mask = m_ctuSize - 1;
+        return ((uint32_t)(pos.x & mask) << 21) | ((uint32_t)(pos.y & mask) << 14)
+             | ((uint32_t)(size.width - 1) << 7) | (uint32_t)(size.height - 1);
+    }
+
+    static uint32_t xHash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return (uint32_t)key;
+    }
+
+    // Slot da chave ou o primeiro livre da sondagem linear
+    uint32_t xFindSlot(const std::vector<Slot>& slots, uint64_t key) const {
+        const uint32_t mask = (uint32_t)slots.size() - 1;
+        uint32_t slot = xHash(key) & mask;
+        while (slots[slot].gen == m_gen && slots[slot].key != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void xReset() {
+        m_numEntries = 0;
+        if (++m_gen == 0) {
+            // volta da geração: limpa os slots para não confundir gerações antigas
+            for (Slot& s : m_entrySlots) s.gen = 0;
+            for (Slot& s : m_blockSlots) s.gen = 0;
+            m_gen = 1;
+        }
+    }
+
+    // Dobra as tabelas e reinsere as entradas da geração atual
+    void xResize(int log2Slots) {
+        m_log2Slots = log2Slots;
+        m_entrySlots.assign((size_t)1 << log2Slots, Slot{ 0, 0, -1 });
+        m_blockSlots.assign((size_t)1 << log2Slots, Slot{ 0, 0, -1 });
+        for (size_t i = 0; i < m_numEntries; i++) {
+            const Entry& entry = m_entries[i];
+            m_entrySlots[xFindSlot(m_entrySlots, entry.key)] = { m_gen, entry.key, (int)i };
+            // a última entrada de cada bloco é a cabeça da lista
+            const uint32_t blockKey = (uint32_t)(entry.key >> 32);
+            m_blockSlots[xFindSlot(m_blockSlots, blockKey)] = { m_gen, blockKey, (int)i };
+        }
+    }
+
+    CtuTag              m_ctu;
+    int                 m_ctuSize    = 0;
+    uint32_t            m_gen        = 1;
+    int                 m_log2Slots  = 0;
+    size_t              m_numEntries = 0;
+    std::vector<Entry>  m_entries;      // arena, reaproveitado entre CTUs
+    std::vector<Slot>   m_entrySlots;   // chave completa -> entrada
+    std::vector<Slot>   m_blockSlots;   // (posição, tamanho) -> entrada mais recente do bloco
+};
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef __CTU_SCOPE_H__
+#define __CTU_SCOPE_H__
+
+#include "CommonLib/CodingStructure.h"
+#include "CommonLib/Slice.h"
+
+namespace CAROL {
+
+// Identifica a CTU (POC + posição) de um bloco, usada para invalidar os caches de escopo de CTU
+struct CtuTag {
+    int poc  = -1;
+    int ctuX = -1;
+    int ctuY = -1;
+    int layerId = -1;
+    int instance = -1;   // codificador do processo (modo multi-QP)
+
+    // Codificador em execução; no modo multi-QP o encmain alterna entre um EncLib por QP, que
+    // codificam as mesmas imagens e não podem herdar os caches uns dos outros
+    static int& currentInstance() {
+        static int s_instance = 0;
+        return s_instance;
+    }
+
+    static CtuTag of(const CodingStructure& cs, const Position& lumaPos) {
+        const int ctuSizeLog2 = floorLog2(cs.pcv->maxCUWidth);
+        CtuTag tag;
+        tag.poc     = cs.slice->getPOC();
+        tag.ctuX    = lumaPos.x >> ctuSizeLog2;
+        tag.ctuY    = lumaPos.y >> ctuSizeLog2;
+        tag.layerId = cs.picture->layerId;
+        tag.instance = currentInstance();
+        return tag;
+    }
+
+    bool operator==(const CtuTag& o) const {
+        return poc == o.poc && ctuX == o.ctuX && ctuY == o.ctuY && layerId == o.layerId && instance == o.instance;
+    }
+    bool operator!=(const CtuTag& o) const { return !(*this == o); }
+};
+
+}
+
+#endif
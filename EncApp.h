@@ -133,6 +133,33 @@ public:
   void  forceMaxNumALFAPS(int n) { m_cEncLib.setMaxNumALFAPS(n); }
   void  forceALFAPSIDShift(int n) { m_cEncLib.setALFAPSIDShift(n); }
   EncLib* CAROL_getEncLib() { return &m_cEncLib; }
+  void  CAROL_initSpeedupCfg()
+  {
+    m_cEncLib.CAROL_setMtsEarlyTerm( m_CAROL_mtsEarlyTerm );
+    m_cEncLib.CAROL_setMtsCache( m_CAROL_mtsCache );
+    m_cEncLib.CAROL_setMtsCacheResiShift( m_CAROL_mtsCacheResiShift );
+    m_cEncLib.CAROL_setMotionPyramid( m_CAROL_motionPyramid );
+    m_cEncLib.CAROL_setMotionPyramidSadTh( m_CAROL_motionPyramidSadTh );
+    m_cEncLib.CAROL_setMotionFieldCache( m_CAROL_motionFieldCache );
+    m_cEncLib.CAROL_setSubPelPlanesMaxRefs( m_CAROL_subPelPlanesMaxRefs );
+    m_cEncLib.CAROL_setSubPelPlanesThreads( m_CAROL_subPelPlanesThreads );
+    m_cEncLib.CAROL_setPredictiveFracRefine( m_CAROL_predictiveFracRefine );
+    m_cEncLib.CAROL_setPredictiveFracRefineBound( m_CAROL_predictiveFracRefineBound );
+    m_cEncLib.CAROL_setSubPelFit( m_CAROL_subPelFit );
+    m_cEncLib.CAROL_setBatchedTzSad( m_CAROL_batchedTzSad );
+    m_cEncLib.CAROL_setBiPredAdaptiveIter( m_CAROL_biPredAdaptiveIter );
+    m_cEncLib.CAROL_setBiPredIterEpsilon( m_CAROL_biPredIterEpsilon );
+    m_cEncLib.CAROL_setAffineFusedGradient( m_CAROL_affineFusedGradient );
+    m_cEncLib.CAROL_setAffineConvergenceTh( m_CAROL_affineConvergenceTh );
+    m_cEncLib.CAROL_setAffineHalfRowsMinArea( m_CAROL_affineHalfRowsMinArea );
+    m_cEncLib.CAROL_setAffineModelIndex( m_CAROL_affineModelIndex );
+    m_cEncLib.CAROL_setAffineModelSatdTh( m_CAROL_affineModelSatdTh );
+    m_cEncLib.CAROL_setAffinePreTestTh( m_CAROL_affinePreTestTh );
+    m_cEncLib.CAROL_setSbtPrefixSumDist( m_CAROL_sbtPrefixSumDist );
+    m_cEncLib.CAROL_setSmvdPredCache( m_CAROL_smvdPredCache );
+    m_cEncLib.CAROL_setIbcRollingHash( m_CAROL_ibcRollingHash );
+    m_cEncLib.CAROL_setRefEarlyTermTh( m_CAROL_refEarlyTermTh );
+  }
   
 
 #if GREEN_METADATA_SEI_ENABLED
@@ -78,6 +78,8 @@ protected:
   // file I/O
   std::string m_inputFileName;                                ///< source file name
   std::string m_bitstreamFileName;                            ///< output bitstream file
+  std::string m_CAROL_profileJsonFile;                        ///< CAROLProfileJson: hot-path profile output (CAROL_PROFILING builds)
+  std::string m_CAROL_histogramFile;                          ///< CAROLHistogramFile: per-size/mode call histogram, CSV or .json (CAROL_PROFILING builds)
   std::string m_reconFileName;                                ///< output reconstruction file
 
   // Lambda modifiers
@@ -360,6 +362,30 @@ protected:
   int       m_MTSIntraMaxCand;                                ///< XZ: Number of additional candidates to test
   int       m_MTSInterMaxCand;                                ///< XZ: Number of additional candidates to test
   int       m_mtsImplicitIntra;
+  bool      m_CAROL_mtsEarlyTerm = false;                     ///< CAROLMtsEarlyTerm: skip inter MTS candidates by RD cost lower bound
+  bool      m_CAROL_mtsCache = false;                         ///< CAROLMtsCache: reuse inter MTS decisions of repeated residuals in a CTU
+  int       m_CAROL_mtsCacheResiShift = 0;                    ///< CAROLMtsCacheResiShift: residual precision dropped before hashing
+  bool      m_CAROL_motionPyramid = false;                    ///< CAROLMotionPyramid: pyramid pre-search for TZ start points
+  double    m_CAROL_motionPyramidSadTh = 8.0;                 ///< CAROLMotionPyramidSadTh: per-sample SAD under which the raster is skipped
+  bool      m_CAROL_motionFieldCache = false;                 ///< CAROLMotionFieldCache: CTU motion field seeding of integer ME
+  int       m_CAROL_subPelPlanesMaxRefs = 0;                  ///< CAROLSubPelPlanesMaxRefs: cap on references with precomputed sub-pel planes
+  int       m_CAROL_subPelPlanesThreads = 0;                  ///< CAROLSubPelPlanesThreads: worker threads filtering the sub-pel planes
+  bool      m_CAROL_predictiveFracRefine = false;             ///< CAROLPredictiveFracRefine: model-ordered early-exit fractional refinement
+  double    m_CAROL_predictiveFracRefineBound = 0.9;          ///< CAROLPredictiveFracRefineBound: lower-bound factor on the model SAD
+  bool      m_CAROL_subPelFit = false;                        ///< CAROLSubPelFit: sub-pel ME by quadratic fit of the integer SADs
+  bool      m_CAROL_batchedTzSad = false;                     ///< CAROLBatchedTzSad: multi-candidate SAD for TZ square/diamond patterns
+  bool      m_CAROL_biPredAdaptiveIter = false;               ///< CAROLBiPredAdaptiveIter: convergence-driven bi-pred iteration count
+  double    m_CAROL_biPredIterEpsilon = 0.005;                ///< CAROLBiPredIterEpsilon: min. relative cost gain to keep iterating
+  bool      m_CAROL_affineFusedGradient = false;              ///< CAROLAffineFusedGradient: fused gradient/normal-equation kernel in affine ME
+  double    m_CAROL_affineConvergenceTh = 0.0;                ///< CAROLAffineConvergenceTh: affine ME stops below this CPMV update
+  int       m_CAROL_affineHalfRowsMinArea = 0;                ///< CAROLAffineHalfRowsMinArea: CU area for a 2:1 row-subsampled first iteration
+  bool      m_CAROL_affineModelIndex = false;                 ///< CAROLAffineModelIndex: seed affine ME from a CTU grid of converged models
+  double    m_CAROL_affineModelSatdTh = 0.0;                  ///< CAROLAffineModelSatdTh: per-sample cost below which an indexed model skips the iterations
+  double    m_CAROL_affinePreTestTh = 0.0;                    ///< CAROLAffinePreTestTh: affine motion (samples) of the quadrant MV fit below which affine AMVP is skipped
+  bool      m_CAROL_sbtPrefixSumDist = false;                 ///< CAROLSbtPrefixSumDist: SBT part distortions from a per-CU prefix-sum SSE map
+  bool      m_CAROL_smvdPredCache = false;                    ///< CAROLSmvdPredCache: reuse SMVD pair distortions and interpolated predictions within a PU search
+  bool      m_CAROL_ibcRollingHash = false;                   ///< CAROLIbcRollingHash: exact-match IBC candidates from a hash index of the left CTUs
+  double    m_CAROL_refEarlyTermTh = 0.0;                     ///< CAROLRefEarlyTermTh: uni-pred cost (bits per 4x4, lambda-scaled) below which further references skip ME (0: off)
 
   bool      m_SBT;                                            ///< Sub-Block Transform for inter blocks
   int       m_SBTFast64WidthTh;
@@ -1087,6 +1113,30 @@ public:
   void  destroy   ();                                         ///< destroy option handling class
   bool  parseCfg  ( int argc, char* argv[] );                ///< parse configuration file to fill member variables
   std::string CAROL_getInputFileName() { return m_inputFileName; }
+  std::string CAROL_getProfileJsonFile() { return m_CAROL_profileJsonFile; }
+  std::string CAROL_getHistogramFile() { return m_CAROL_histogramFile; }
+
+  // Modo multi-QP: acrescenta o sufixo (ex.: "_qp22") ao bitstream e à reconstrução, antes da extensão
+  void CAROL_addOutputSuffix(const std::string &suffix)
+  {
+    for (std::string *fileName : { &m_bitstreamFileName, &m_reconFileName })
+    {
+      if (fileName->empty())
+      {
+        continue;
+      }
+      const size_t slashPos = fileName->find_last_of("/\\");
+      const size_t extPos   = fileName->find_last_of(".");
+      if (extPos != std::string::npos && (slashPos == std::string::npos || extPos > slashPos))
+      {
+        fileName->insert(extPos, suffix);
+      }
+      else
+      {
+        fileName->append(suffix);
+      }
+    }
+  }
 };
 
 //! \}
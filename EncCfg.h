@@ -270,6 +270,32 @@ protected:
   bool m_intraOnlyConstraintFlag;
   std::string m_CAROL_inputFileName;
 
+  //====== CAROL speed-ups ========
+  bool      m_CAROL_mtsEarlyTerm = false;           ///< skip inter MTS candidates whose RD cost lower bound exceeds the best cost
+  bool      m_CAROL_mtsCache = false;               ///< per-CTU cache of inter MTS decisions keyed on (area, residual hash)
+  int       m_CAROL_mtsCacheResiShift = 0;          ///< residual samples are right-shifted before hashing (0: exact match)
+  bool      m_CAROL_motionPyramid = false;          ///< hierarchical per-CTU pre-search feeding xTZSearch start points
+  double    m_CAROL_motionPyramidSadTh = 8.0;       ///< max. per-sample SAD of the pyramid match to skip the raster stage
+  bool      m_CAROL_motionFieldCache = false;       ///< CTU-scoped 8x8 motion field seeding uni-pred integer ME
+  int       m_CAROL_subPelPlanesMaxRefs = 0;        ///< references with precomputed 1/4-pel luma planes kept in memory (0: off)
+  int       m_CAROL_subPelPlanesThreads = 0;        ///< threads building the sub-pel planes (<= 1: encoder thread only)
+  bool      m_CAROL_predictiveFracRefine = false;   ///< order/prune xPatternRefinement candidates by the integer SAD surface
+  double    m_CAROL_predictiveFracRefineBound = 0.9; ///< factor on the scaled model SAD used as lower bound
+  bool      m_CAROL_subPelFit = false;              ///< fractional ME from the integer SAD surface minimum plus one verification
+  bool      m_CAROL_batchedTzSad = false;           ///< SADs of each TZ square/diamond pattern computed together (original rows loaded once)
+  bool      m_CAROL_biPredAdaptiveIter = false;     ///< stop the L0/L1 bi-pred refinement once cost or MV stop changing
+  double    m_CAROL_biPredIterEpsilon = 0.005;      ///< relative cost gain under which a bi-pred iteration counts as converged
+  bool      m_CAROL_affineFusedGradient = false;    ///< affine ME residual, Sobel and normal equations in one SIMD pass
+  double    m_CAROL_affineConvergenceTh = 0.0;      ///< stop affine Gauss-Newton when the largest CPMV update is below this (AMVR units, 0: off)
+  int       m_CAROL_affineHalfRowsMinArea = 0;      ///< min. CU area whose first affine iteration uses every other row (0: off)
+  bool      m_CAROL_affineModelIndex = false;       ///< seed affine ME from an 8x8 CTU grid of converged affine models
+  double    m_CAROL_affineModelSatdTh = 0.0;        ///< per-sample SATD below which the indexed model skips the affine iterations (0: never)
+  double    m_CAROL_affinePreTestTh = 0.0;          ///< affine part (RMS samples) of the quadrant MV fit below which affine AMVP is skipped (0: off)
+  bool      m_CAROL_sbtPrefixSumDist = false;       ///< SBT part distortions from a per-CU 2D prefix-sum of the SSE
+  bool      m_CAROL_smvdPredCache = false;          ///< per-PU cache of SMVD pair distortions and interpolated predictions
+  bool      m_CAROL_ibcRollingHash = false;         ///< rolling-hash index of the IBC reference area queried before the SAD scans
+  double    m_CAROL_refEarlyTermTh = 0.0;           ///< rank references and stop uni-pred ME once the cost is below this many bits per 4x4 (0: off)
+
   //====== Coding Structure ========
   int       m_intraPeriod;                        // needs to be signed to allow '-1' for no intra period
   uint32_t  m_decodingRefreshType;            ///< the type of decoding refresh employed for the random access.
@@ -1253,6 +1279,55 @@ public:
 
   std::string CAROL_getInputFileName() const { return m_CAROL_inputFileName; }
 
+  void      CAROL_setMtsEarlyTerm           ( bool b )       { m_CAROL_mtsEarlyTerm = b; }
+  bool      CAROL_getMtsEarlyTerm           ()         const { return m_CAROL_mtsEarlyTerm; }
+  void      CAROL_setMtsCache               ( bool b )       { m_CAROL_mtsCache = b; }
+  bool      CAROL_getMtsCache               ()         const { return m_CAROL_mtsCache; }
+  void      CAROL_setMtsCacheResiShift      ( int i )        { m_CAROL_mtsCacheResiShift = i; }
+  int       CAROL_getMtsCacheResiShift      ()         const { return m_CAROL_mtsCacheResiShift; }
+  void      CAROL_setMotionPyramid          ( bool b )       { m_CAROL_motionPyramid = b; }
+  bool      CAROL_getMotionPyramid          ()         const { return m_CAROL_motionPyramid; }
+  void      CAROL_setMotionPyramidSadTh     ( double d )     { m_CAROL_motionPyramidSadTh = d; }
+  double    CAROL_getMotionPyramidSadTh     ()         const { return m_CAROL_motionPyramidSadTh; }
+  void      CAROL_setMotionFieldCache       ( bool b )       { m_CAROL_motionFieldCache = b; }
+  bool      CAROL_getMotionFieldCache       ()         const { return m_CAROL_motionFieldCache; }
+  void      CAROL_setSubPelPlanesMaxRefs    ( int i )        { m_CAROL_subPelPlanesMaxRefs = i; }
+  int       CAROL_getSubPelPlanesMaxRefs    ()         const { return m_CAROL_subPelPlanesMaxRefs; }
+  void      CAROL_setSubPelPlanesThreads    ( int i )        { m_CAROL_subPelPlanesThreads = i; }
+  int       CAROL_getSubPelPlanesThreads    ()         const { return m_CAROL_subPelPlanesThreads; }
+  void      CAROL_setPredictiveFracRefine   ( bool b )       { m_CAROL_predictiveFracRefine = b; }
+  bool      CAROL_getPredictiveFracRefine   ()         const { return m_CAROL_predictiveFracRefine; }
+  void      CAROL_setPredictiveFracRefineBound( double d )   { m_CAROL_predictiveFracRefineBound = d; }
+  double    CAROL_getPredictiveFracRefineBound()       const { return m_CAROL_predictiveFracRefineBound; }
+  void      CAROL_setSubPelFit              ( bool b )       { m_CAROL_subPelFit = b; }
+  bool      CAROL_getSubPelFit              ()         const { return m_CAROL_subPelFit; }
+  void      CAROL_setBatchedTzSad           ( bool b )       { m_CAROL_batchedTzSad = b; }
+  bool      CAROL_getBatchedTzSad           ()         const { return m_CAROL_batchedTzSad; }
+  void      CAROL_setBiPredAdaptiveIter     ( bool b )       { m_CAROL_biPredAdaptiveIter = b; }
+  bool      CAROL_getBiPredAdaptiveIter     ()         const { return m_CAROL_biPredAdaptiveIter; }
+  void      CAROL_setBiPredIterEpsilon      ( double d )     { m_CAROL_biPredIterEpsilon = d; }
+  double    CAROL_getBiPredIterEpsilon      ()         const { return m_CAROL_biPredIterEpsilon; }
+  void      CAROL_setAffineFusedGradient    ( bool b )       { m_CAROL_affineFusedGradient = b; }
+  bool      CAROL_getAffineFusedGradient    ()         const { return m_CAROL_affineFusedGradient; }
+  void      CAROL_setAffineConvergenceTh    ( double d )     { m_CAROL_affineConvergenceTh = d; }
+  double    CAROL_getAffineConvergenceTh    ()         const { return m_CAROL_affineConvergenceTh; }
+  void      CAROL_setAffineHalfRowsMinArea  ( int i )        { m_CAROL_affineHalfRowsMinArea = i; }
+  int       CAROL_getAffineHalfRowsMinArea  ()         const { return m_CAROL_affineHalfRowsMinArea; }
+  void      CAROL_setAffineModelIndex       ( bool b )       { m_CAROL_affineModelIndex = b; }
+  bool      CAROL_getAffineModelIndex       ()         const { return m_CAROL_affineModelIndex; }
+  void      CAROL_setAffineModelSatdTh      ( double d )     { m_CAROL_affineModelSatdTh = d; }
+  double    CAROL_getAffineModelSatdTh      ()         const { return m_CAROL_affineModelSatdTh; }
+  void      CAROL_setAffinePreTestTh        ( double d )     { m_CAROL_affinePreTestTh = d; }
+  double    CAROL_getAffinePreTestTh        ()         const { return m_CAROL_affinePreTestTh; }
+  void      CAROL_setSbtPrefixSumDist       ( bool b )       { m_CAROL_sbtPrefixSumDist = b; }
+  bool      CAROL_getSbtPrefixSumDist       ()         const { return m_CAROL_sbtPrefixSumDist; }
+  void      CAROL_setSmvdPredCache          ( bool b )       { m_CAROL_smvdPredCache = b; }
+  bool      CAROL_getSmvdPredCache          ()         const { return m_CAROL_smvdPredCache; }
+  void      CAROL_setIbcRollingHash         ( bool b )       { m_CAROL_ibcRollingHash = b; }
+  bool      CAROL_getIbcRollingHash         ()         const { return m_CAROL_ibcRollingHash; }
+  void      CAROL_setRefEarlyTermTh         ( double d )     { m_CAROL_refEarlyTermTh = d; }
+  double    CAROL_getRefEarlyTermTh         ()         const { return m_CAROL_refEarlyTermTh; }
+
   void setValidFrames(const int first, const int last)
   {
     m_firstValidFrame = first;
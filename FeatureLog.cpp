@@ -12,15 +12,20 @@
 
 namespace CAROL {
 
+// Início de linha pendente e o QP do codificador que o escreveu
+struct PendingLine {
+    std::string text;
+    int qp = 0;
+};
+
 // Estrutura global para evitar conflitos entre threads 
-static std::map<std::string, std::string> g_lineBuffer;
+static std::map<std::string, PendingLine> g_lineBuffer;
 static std::mutex g_logMutex;
 
-// Globals for reservoir sampling
-static std::map<std::string, std::vector<std::string>> g_reservoirs;
-static std::map<std::string, uint64_t> g_counts;
+// Globals for reservoir sampling, por (QP, tamanho de bloco): no modo multi-QP cada QP tem seus CSVs
+static std::map<std::pair<int, std::string>, std::vector<std::string>> g_reservoirs;
+static std::map<std::pair<int, std::string>, uint64_t> g_counts;
 static std::string g_videoName;
-static int g_qp = 0;
 static const size_t RESERVOIR_SIZE = 7000;
 static std::mt19937_64 g_rng(std::random_device{}());
 
@@ -40,8 +45,8 @@ struct ReservoirFlusher {
                   "Resi_SAD,Resi_LastRowSum,Resi_LastColSum,Resi_TL,Resi_TR,Resi_BR,"                  
                   "Transformada";
 
-        for (auto const& [blockSize, lines] : g_reservoirs) {
-            std::string fileName = g_videoName + "-" + std::to_string(g_qp) + "-" + blockSize + ".csv";
+        for (auto const& [qpAndSize, lines] : g_reservoirs) {
+            std::string fileName = g_videoName + "-" + std::to_string(qpAndSize.first) + "-" + qpAndSize.second + ".csv";
             std::ofstream outFile(fileName);
             if (outFile.is_open()) {
                 outFile << header << std::endl;
@@ -56,12 +61,11 @@ struct ReservoirFlusher {
 
 static ReservoirFlusher g_flusher;
 
-void FeatureLogger::init(const std::string& inputName, int qp) {
+void FeatureLogger::init(const std::string& inputName) {
     std::lock_guard<std::mutex> lock(g_logMutex);
     if (m_initialized) return;
 
     g_videoName = inputName;
-    g_qp = qp;
     m_initialized = true;
 }
 
@@ -111,7 +115,7 @@ std::string FeatureLogger::startLine(const PredictionUnit& pu, const BlockFeatur
        << CAROL::determine_aspect_ratio_group(w, h);
 
     // armazena no buffer global usando a key (POC_X_Y)
-    g_lineBuffer[key] = ss.str();
+    g_lineBuffer[key] = { ss.str(), baseQP };
     return key;
 }
 
@@ -124,7 +128,8 @@ void FeatureLogger::endLine(const CodingUnit& cu) {
     if (!m_initialized) return;
 
     // só escreve se houver um início de linha correspondente
-    if (!key.empty() && g_lineBuffer.find(key) != g_lineBuffer.end()) {
+    auto pending = key.empty() ? g_lineBuffer.end() : g_lineBuffer.find(key);
+    if (pending != g_lineBuffer.end()) {
         std::string transName = "UNKNOWN";
         if (cu.rootCbf) {
             switch (cu.firstTU->mtsIdx[COMPONENT_Y]) {
@@ -139,28 +144,30 @@ void FeatureLogger::endLine(const CodingUnit& cu) {
         }
 
         // Constrói a linha completa
-        std::string fullLine = g_lineBuffer[key] + "," + transName;
+        std::string fullLine = pending->second.text + "," + transName;
 
         // Determina o tamanho do bloco para o reservatório
         const CompArea& blk = cu.blocks[getFirstComponentOfChannel(cu.chType)];
         std::string blockSize = std::to_string(blk.width) + "x" + std::to_string(blk.height);
+        const std::pair<int, std::string> reservoirKey(pending->second.qp, blockSize);
 
         // Amostragem de Reservatório
-        uint64_t& count = g_counts[blockSize];
+        uint64_t& count = g_counts[reservoirKey];
         count++;
 
-        if (g_reservoirs[blockSize].size() < RESERVOIR_SIZE) {
-            g_reservoirs[blockSize].push_back(fullLine);
+        std::vector<std::string>& reservoir = g_reservoirs[reservoirKey];
+        if (reservoir.size() < RESERVOIR_SIZE) {
+            reservoir.push_back(fullLine);
         } else {
             std::uniform_int_distribution<uint64_t> dist(0, count - 1);
             uint64_t j = dist(g_rng);
             if (j < RESERVOIR_SIZE) {
-                g_reservoirs[blockSize][j] = fullLine;
+                reservoir[j] = fullLine;
             }
         }
 
         // limpa o buffer para liberar memória 
-        g_lineBuffer.erase(key);
+        g_lineBuffer.erase(pending);
     }
 }
 
@@ -29,10 +29,10 @@ public:
         return instance;
     }
 
-    // Inicializa o arquivo CSV com base no nome do input e QP
-    void init(const std::string& inputName, int qp);
+    // Inicializa os arquivos CSV com base no nome do input (um conjunto por QP)
+    void init(const std::string& inputName);
 
-    // Escreve a primeira parte da linha (Features + Geometria)
+    // Escreve a primeira parte da linha (Features + Geometria); qp escolhe os CSVs da linha
     std::string startLine(const PredictionUnit& pu, const BlockFeatures& feats, int qp);
 
     // Escreve a parte final (Transformada) e quebra a linha
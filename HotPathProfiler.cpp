@@ -0,0 +1,88 @@
+#include "HotPathProfiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace CAROL {
+
+static const char* g_timerNames[(int)TimerId::NUM] = {
+    "predInterSearch",
+    "xMotionEstimation",
+    "xTZSearch",
+    "xAffineMotionEstimation",
+    "xEstimateInterResidualQT",
+    "extract_block_features",
+};
+
+// Registro global dos contadores de cada thread (as threads do encoder vivem até o fim da codificação)
+static std::mutex g_profilerMutex;
+static std::vector<std::unique_ptr<TimerCounter[]>> g_threadCounters;
+
+// Referência para converter ciclos em segundos
+static const uint64_t g_startCycles = HotPathProfiler::readCycles();
+static const auto     g_startTime   = std::chrono::steady_clock::now();
+
+TimerCounter* HotPathProfiler::threadCounters() {
+    thread_local TimerCounter* counters = nullptr;
+    if (counters == nullptr) {
+        std::lock_guard<std::mutex> lock(g_profilerMutex);
+        g_threadCounters.emplace_back(new TimerCounter[(int)TimerId::NUM]);
+        counters = g_threadCounters.back().get();
+    }
+    return counters;
+}
+
+// Soma dos contadores de todas as threads e ciclos por segundo medidos desde o início
+static std::vector<TimerCounter> collect(double& cyclesPerSec) {
+    std::lock_guard<std::mutex> lock(g_profilerMutex);
+    std::vector<TimerCounter> total((int)TimerId::NUM);
+    for (const auto& counters : g_threadCounters) {
+        for (int i = 0; i < (int)TimerId::NUM; i++) {
+            total[i].calls  += counters[i].calls;
+            total[i].cycles += counters[i].cycles;
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_startTime).count();
+    cyclesPerSec = elapsed > 0 ? (double)(HotPathProfiler::readCycles() - g_startCycles) / elapsed : 0.0;
+    return total;
+}
+
+void HotPathProfiler::report(FILE* fp) {
+    double cyclesPerSec = 0;
+    const std::vector<TimerCounter> total = collect(cyclesPerSec);
+
+    fprintf(fp, "\n CAROL hot-path profile (inclusive)\n");
+    fprintf(fp, "  %-26s %14s %18s %12s %14s\n", "function", "calls", "cycles", "sec", "cycles/call");
+    for (int i = 0; i < (int)TimerId::NUM; i++) {
+        if (total[i].calls == 0) continue;
+        fprintf(fp, "  %-26s %14llu %18llu %12.3f %14.1f\n", g_timerNames[i],
+                (unsigned long long)total[i].calls, (unsigned long long)total[i].cycles,
+                cyclesPerSec > 0 ? total[i].cycles / cyclesPerSec : 0.0,
+                (double)total[i].cycles / (double)total[i].calls);
+    }
+}
+
+void HotPathProfiler::writeJson(const std::string& fileName) {
+    if (fileName.empty()) return;
+
+    double cyclesPerSec = 0;
+    const std::vector<TimerCounter> total = collect(cyclesPerSec);
+
+    std::ofstream out(fileName);
+    if (!out.is_open()) return;
+
+    out << "{\n  \"cyclesPerSecond\": " << (uint64_t)cyclesPerSec << ",\n  \"functions\": [\n";
+    bool first = true;
+    for (int i = 0; i < (int)TimerId::NUM; i++) {
+        if (total[i].calls == 0) continue;
+        out << (first ? "" : ",\n") << "    { \"name\": \"" << g_timerNames[i] << "\", \"calls\": " << total[i].calls
+            << ", \"cycles\": " << total[i].cycles << " }";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+}
+
+}
@@ -0,0 +1,99 @@
+#ifndef __HOT_PATH_PROFILER_H__
+#define __HOT_PATH_PROFILER_H__
+
+// Instrumentação dos pontos quentes do InterSearch (ciclos por função).
+// Desabilitada por padrão: compile com -DCAROL_PROFILING=1 para habilitar.
+// Com CAROL_PROFILING=0 a macro CAROL_SCOPED_TIMER não gera código.
+#ifndef CAROL_PROFILING
+#define CAROL_PROFILING 0
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#if CAROL_PROFILING
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+namespace CAROL {
+
+// Funções instrumentadas (os tempos são inclusivos: xTZSearch também conta em xMotionEstimation).
+// Numa função recursiva (xEstimateInterResidualQT nas divisões de TU) só a chamada mais externa é medida.
+enum class TimerId : int {
+    PRED_INTER_SEARCH = 0,
+    MOTION_ESTIMATION,
+    TZ_SEARCH,
+    AFFINE_MOTION_ESTIMATION,
+    ESTIMATE_INTER_RESIDUAL_QT,
+    EXTRACT_BLOCK_FEATURES,
+    NUM
+};
+
+struct TimerCounter {
+    uint64_t calls  = 0;
+    uint64_t cycles = 0;
+    uint32_t depth  = 0;   // temporizadores abertos desta função na thread
+};
+
+class HotPathProfiler {
+public:
+    static inline uint64_t readCycles() {
+#if CAROL_PROFILING && (defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__))
+        return __rdtsc();
+#elif CAROL_PROFILING
+        return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#else
+        return 0;
+#endif
+    }
+
+    // Contadores da thread atual (registrados na primeira chamada para o relatório final)
+    static TimerCounter* threadCounters();
+
+    // Soma os contadores de todas as threads e imprime o relatório
+    static void report(FILE* fp);
+
+    // Escreve o mesmo relatório em JSON (ignorado se o nome do arquivo for vazio)
+    static void writeJson(const std::string& fileName);
+};
+
+// Temporizador de escopo: acumula os ciclos entre construção e destruição do mais externo da função
+class ScopedTimer {
+public:
+    explicit ScopedTimer(TimerId id)
+        : m_counter(HotPathProfiler::threadCounters() + (int)id)
+        , m_start(m_counter->depth++ == 0 ? HotPathProfiler::readCycles() : 0) {}
+
+    ~ScopedTimer() {
+        if (--m_counter->depth == 0) {
+            m_counter->cycles += HotPathProfiler::readCycles() - m_start;
+            m_counter->calls++;
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    void operator=(const ScopedTimer&) = delete;
+
+private:
+    TimerCounter* m_counter;
+    uint64_t      m_start;
+};
+
+}
+
+#if CAROL_PROFILING
+#define CAROL_SCOPED_TIMER_CAT2(a, b) a##b
+#define CAROL_SCOPED_TIMER_CAT(a, b)  CAROL_SCOPED_TIMER_CAT2(a, b)
+#define CAROL_SCOPED_TIMER(id)        CAROL::ScopedTimer CAROL_SCOPED_TIMER_CAT(carolTimer_, __LINE__)(CAROL::TimerId::id)
+#else
+#define CAROL_SCOPED_TIMER(id)
+#endif
+
+#endif
@@ -0,0 +1,171 @@
+#include "IbcHashIndex.h"
+
+#include <algorithm>
+
+namespace CAROL {
+
+static const uint32_t ROW_MUL   = 0x9E3779B1u;
+static const uint32_t COL_MUL   = 0x85EBCA77u;
+static const uint32_t QUAD_MUL  = 0xC2B2AE3Du;
+
+static inline uint32_t xMix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+static inline uint32_t xRowHash(const Pel* p) {
+    return ((((uint32_t)(uint16_t)p[0] * ROW_MUL + (uint16_t)p[1]) * ROW_MUL + (uint16_t)p[2]) * ROW_MUL) + (uint16_t)p[3];
+}
+
+static inline uint32_t xColHash(uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3) {
+    return ((r0 * COL_MUL + r1) * COL_MUL + r2) * COL_MUL + r3;
+}
+
+static inline uint32_t xQuadHash(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br) {
+    return xMix(((tl * QUAD_MUL + tr) * QUAD_MUL + bl) * QUAD_MUL + br);
+}
+
+uint32_t IbcHashIndex::hashBlock(const Pel* p, ptrdiff_t stride, int log2Size) {
+    if (log2Size == MIN_LOG2_SIZE) {
+        return xColHash(xRowHash(p), xRowHash(p + stride), xRowHash(p + 2 * stride), xRowHash(p + 3 * stride));
+    }
+    const int half = 1 << (log2Size - 1);
+    return xQuadHash(hashBlock(p, stride, log2Size - 1), hashBlock(p + half, stride, log2Size - 1),
+                     hashBlock(p + half * stride, stride, log2Size - 1),
+                     hashBlock(p + half * stride + half, stride, log2Size - 1));
+}
+
+void IbcHashIndex::xInsert(Table& table, uint32_t hash, int x, int y) {
+    const int bucket = (int)(xMix(hash) & (uint32_t)(table.heads.size() - 1));
+    table.entries.push_back({ hash, x, y, table.heads[bucket] });
+    table.heads[bucket] = (int)table.entries.size() - 1;
+}
+
+void IbcHashIndex::xBuild(Segment& segment, int ctuX, const CPelBuf& reco) {
+    segment.ctuX = ctuX;
+    const int x0     = ctuX * m_ctuSize;
+    const int y0     = m_ctuY * m_ctuSize;
+    const int width  = std::min(m_ctuSize, (int)reco.width - x0);
+    const int height = std::min(m_ctuSize, (int)reco.height - y0);
+
+    for (int s = 0; s < NUM_SIZES; s++) {
+        const int size = 1 << (s + MIN_LOG2_SIZE);
+        Table&    t    = segment.tables[s];
+        t.entries.clear();
+        const int numPos = std::max(0, width - size + 1) * std::max(0, height - size + 1);
+        int log2Heads = 4;
+        while ((1 << log2Heads) < numPos) log2Heads++;
+        t.heads.assign((size_t)1 << log2Heads, -1);
+        t.entries.reserve(numPos);
+    }
+    if (width < 4 || height < 4) {
+        return;
+    }
+
+    // hashes de linha rolantes: r(x + 1) = (r(x) - p[x] * ROW_MUL^3) * ROW_MUL + p[x + 4]
+    const uint32_t rowMul3 = ROW_MUL * ROW_MUL * ROW_MUL;
+    const int      rowW    = width - 3;
+    m_rowHash.resize((size_t)rowW * height);
+    for (int y = 0; y < height; y++) {
+        const Pel* p = reco.bufAt(x0, y0 + y);
+        uint32_t*  r = m_rowHash.data() + (size_t)y * rowW;
+        r[0] = xRowHash(p);
+        for (int x = 1; x < rowW; x++) {
+            r[x] = (r[x - 1] - (uint32_t)(uint16_t)p[x - 1] * rowMul3) * ROW_MUL + (uint16_t)p[x + 3];
+        }
+    }
+
+    // 4x4 a partir das linhas; 8x8 e 16x16 dos quatro quadrantes do tamanho anterior
+    for (int s = 0; s < NUM_SIZES; s++) {
+        const int size = 1 << (s + MIN_LOG2_SIZE);
+        const int bw   = width - size + 1;
+        const int bh   = height - size + 1;
+        if (bw <= 0 || bh <= 0) {
+            break;
+        }
+        std::vector<uint32_t>& h = m_blockHash[s];
+        h.resize((size_t)bw * bh);
+        if (s == 0) {
+            for (int y = 0; y < bh; y++) {
+                const uint32_t* r = m_rowHash.data() + (size_t)y * rowW;
+                for (int x = 0; x < bw; x++) {
+                    h[(size_t)y * bw + x] = xColHash(r[x], r[x + rowW], r[x + 2 * rowW], r[x + 3 * rowW]);
+                }
+            }
+        } else {
+            const std::vector<uint32_t>& q = m_blockHash[s - 1];
+            const int qw   = width - size / 2 + 1;
+            const int half = size / 2;
+            for (int y = 0; y < bh; y++) {
+                for (int x = 0; x < bw; x++) {
+                    h[(size_t)y * bw + x] = xQuadHash(q[(size_t)y * qw + x], q[(size_t)y * qw + x + half],
+                                                      q[(size_t)(y + half) * qw + x], q[(size_t)(y + half) * qw + x + half]);
+                }
+            }
+        }
+        Table& t = segment.tables[s];
+        for (int y = 0; y < bh; y++) {
+            for (int x = 0; x < bw; x++) {
+                xInsert(t, h[(size_t)y * bw + x], x0 + x, y0 + y);
+            }
+        }
+    }
+}
+
+void IbcHashIndex::update(const CtuTag& tag, int ctuSize, int numLeftCtus, const CPelBuf& reco) {
+    if (tag.poc != m_poc || tag.layerId != m_layerId || tag.instance != m_instance || tag.ctuY != m_ctuY || ctuSize != m_ctuSize || reco.buf != m_recoBuf
+        || (int)m_segments.size() != numLeftCtus) {
+        m_poc      = tag.poc;
+        m_layerId  = tag.layerId;
+        m_instance = tag.instance;
+        m_ctuY     = tag.ctuY;
+        m_ctuSize  = ctuSize;
+        m_recoBuf  = reco.buf;
+        m_nextCtuX = 0;
+        m_segments.resize(numLeftCtus);
+        for (Segment& segment : m_segments) {
+            segment.ctuX = -1;
+        }
+    }
+    if (numLeftCtus <= 0) {
+        return;
+    }
+
+    const int first = std::max(m_nextCtuX, tag.ctuX - numLeftCtus);
+    for (int c = first; c < tag.ctuX; c++) {
+        xBuild(m_segments[c % numLeftCtus], c, reco);
+    }
+    m_nextCtuX = std::max(m_nextCtuX, tag.ctuX);
+    m_curCtuX  = tag.ctuX;
+}
+
+int IbcHashIndex::lookup(int log2Size, uint32_t hash, Position matches[MAX_MATCHES]) const {
+    const int s          = log2Size - MIN_LOG2_SIZE;
+    const int numSegs    = (int)m_segments.size();
+    int       numMatches = 0;
+    for (int c = m_curCtuX - 1; c >= m_curCtuX - numSegs && c >= 0 && numMatches < MAX_MATCHES; c--) {
+        const Segment& segment = m_segments[c % numSegs];
+        if (segment.ctuX != c) {
+            continue;
+        }
+        const Table& t = segment.tables[s];
+        if (t.entries.empty()) {
+            continue;
+        }
+        const int bucket = (int)(xMix(hash) & (uint32_t)(t.heads.size() - 1));
+        for (int i = t.heads[bucket]; i >= 0 && numMatches < MAX_MATCHES; i = t.entries[i].next) {
+            if (t.entries[i].hash == hash) {
+                matches[numMatches].x = t.entries[i].x;
+                matches[numMatches].y = t.entries[i].y;
+                numMatches++;
+            }
+        }
+    }
+    return numMatches;
+}
+
+}
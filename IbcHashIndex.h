@@ -0,0 +1,69 @@
+#ifndef __IBC_HASH_INDEX_H__
+#define __IBC_HASH_INDEX_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CommonLib/Buffer.h"
+#include "CtuScope.h"
+#include <cstdint>
+#include <vector>
+
+namespace CAROL {
+
+// Índice de hash dos blocos 4x4, 8x8 e 16x16 (todas as posições inteiras) das CTUs já reconstruídas
+// à esquerda na linha de CTUs atual, a área de referência do IBC. Cada CTU entra uma vez, quando a busca
+// passa para a seguinte, e sai quando deixa a faixa de referência. Os hashes de linha são rolantes; os
+// de 8x8 e 16x16 combinam os quatro quadrantes, então o hash do bloco original sai do mesmo cálculo.
+class IbcHashIndex {
+public:
+    static const int MIN_LOG2_SIZE = 2;
+    static const int MAX_LOG2_SIZE = 4;
+    static const int NUM_SIZES     = MAX_LOG2_SIZE - MIN_LOG2_SIZE + 1;
+    static const int MAX_MATCHES   = 16;
+
+    // Mantém as CTUs [ctuX - numLeftCtus, ctuX - 1] da linha de tag; reco é a luma reconstruída da imagem.
+    // Outra imagem ou outra linha de CTUs recomeça o índice.
+    void update(const CtuTag& tag, int ctuSize, int numLeftCtus, const CPelBuf& reco);
+
+    // Hash do bloco (1 << log2Size) x (1 << log2Size) em p
+    static uint32_t hashBlock(const Pel* p, ptrdiff_t stride, int log2Size);
+
+    // Posições (luma da imagem) dos blocos indexados com esse hash, das CTUs mais recentes primeiro
+    int lookup(int log2Size, uint32_t hash, Position matches[MAX_MATCHES]) const;
+
+private:
+    struct Entry {
+        uint32_t hash;
+        int      x;
+        int      y;
+        int      next;      // entrada anterior do mesmo balde, -1 no fim
+    };
+
+    struct Table {
+        std::vector<Entry> entries;
+        std::vector<int>   heads;
+    };
+
+    struct Segment {
+        int   ctuX = -1;    // -1: vazio
+        Table tables[NUM_SIZES];
+    };
+
+    void xBuild(Segment& segment, int ctuX, const CPelBuf& reco);
+    static void xInsert(Table& table, uint32_t hash, int x, int y);
+
+    int                  m_poc      = -1;
+    int                  m_layerId  = -1;
+    int                  m_instance = -1;
+    int                  m_ctuY     = -1;
+    int                  m_ctuSize  = 0;
+    const Pel*           m_recoBuf  = nullptr;
+    int                  m_nextCtuX = 0;    // primeira CTU ainda não indexada
+    int                  m_curCtuX  = 0;    // CTU da busca atual
+    std::vector<Segment> m_segments;        // anel indexado por ctuX % tamanho
+    std::vector<uint32_t> m_rowHash;
+    std::vector<uint32_t> m_blockHash[NUM_SIZES];
+};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef __INT_COST_SURFACE_H__
+#define __INT_COST_SURFACE_H__
+
+#include "CommonLib/CommonDef.h"
+#include <cstdint>
+
+namespace CAROL {
+
+// SADs inteiros amostrados pelo xTZSearch (tabela 16x16 de mapeamento direto pela posição).
+// Ao fim da busca, o melhor ponto e os 4 vizinhos definem um modelo quadrático separável
+// usado para ordenar e podar os candidatos do refinamento fracionário.
+class IntCostSurface {
+public:
+    static const int LOG2_SIZE = 4;
+
+    // SAD(dx, dy) ~ c + bx*dx + ax*dx^2 + by*dy + ay*dy^2 (dx, dy em amostras, relativos ao centro)
+    struct Model {
+        double c  = 0;
+        double bx = 0, ax = 0;
+        double by = 0, ay = 0;
+        double at(double dx, double dy) const { return c + (bx + ax * dx) * dx + (by + ay * dy) * dy; }
+    };
+
+    // Nova busca; owner identifica (lista, refIdx, bloco, bi-pred) para o ajuste posterior
+    void begin(uint64_t owner) {
+        m_owner  = owner;
+        m_active = true;
+        if (++m_gen == 0) {
+            for (Point& p : m_points) p.gen = 0;
+            m_gen = 1;
+        }
+    }
+    void end() { m_active = false; }
+    bool isActive() const { return m_active; }
+
+    // Ativa o registro durante uma busca e desativa no destrutor (cobre os retornos antecipados)
+    class Scope {
+    public:
+        Scope(IntCostSurface& surface, bool enabled, uint64_t owner) : m_surface(enabled ? &surface : nullptr) {
+            if (m_surface) m_surface->begin(owner);
+        }
+        ~Scope() { if (m_surface) m_surface->end(); }
+        Scope(const Scope&) = delete;
+        void operator=(const Scope&) = delete;
+    private:
+        IntCostSurface* m_surface;
+    };
+
+    void record(int x, int y, Distortion sad) {
+        Point& p = m_points[xIndex(x, y)];
+        p.gen = m_gen;
+        p.x   = x;
+        p.y   = y;
+        p.sad = sad;
+    }
+
+    // Ajusta o modelo em torno de (cx, cy); false se algum vizinho não foi amostrado pela última
+    // busca de owner ou se a superfície não é convexa nos dois eixos
+    bool fit(uint64_t owner, int cx, int cy, Model& model) const {
+        Distortion c, l, r, t, b;
+        if (owner != m_owner || !xGet(cx, cy, c) || !xGet(cx - 1, cy, l) || !xGet(cx + 1, cy, r)
+            || !xGet(cx, cy - 1, t) || !xGet(cx, cy + 1, b)) {
+            return false;
+        }
+        model.c  = (double)c;
+        model.bx = ((double)r - (double)l) / 2;
+        model.ax = ((double)r + (double)l) / 2 - (double)c;
+        model.by = ((double)b - (double)t) / 2;
+        model.ay = ((double)b + (double)t) / 2 - (double)c;
+        return model.ax > 0 && model.ay > 0;
+    }
+
+private:
+    struct Point {
+        uint32_t   gen = 0;
+        int        x   = 0;
+        int        y   = 0;
+        Distortion sad = 0;
+    };
+
+    static int xIndex(int x, int y) {
+        const int mask = (1 << LOG2_SIZE) - 1;
+        return (x & mask) | ((y & mask) << LOG2_SIZE);
+    }
+
+    bool xGet(int x, int y, Distortion& sad) const {
+        const Point& p = m_points[xIndex(x, y)];
+        if (p.gen != m_gen || p.x != x || p.y != y) {
+            return false;
+        }
+        sad = p.sad;
+        return true;
+    }
+
+    Point    m_points[1 << (2 * LOG2_SIZE)];
+    uint32_t m_gen    = 1;
+    uint64_t m_owner  = 0;
+    bool     m_active = false;
+};
+
+}
+
+#endif
@@ -40,6 +40,26 @@
 // includes criados
 #include "FeatureLog.h"
 #include "FeatureLog.cpp"
+#include "SpeedupStats.h"
+#include "MtsLowerBound.h"
+#include "MtsDecisionCache.h"
+#include "HotPathProfiler.h"
+#include "BlockHistogram.h"
+#include "MotionPyramid.h"
+#include "MotionFieldCache.h"
+#include "WorkerPool.h"
+#include "BvHistoryTable.h"
+#include "SubPelPlanes.h"
+#include "IntCostSurface.h"
+#include "TZSadBatch.h"
+#include "AffineNormalEquation.h"
+#include "AffineModelIndex.h"
+#include "AffineLikelihood.h"
+#include "SbtDistortionMap.h"
+#include "SymmetricPredCache.h"
+#include "IbcHashIndex.h"
+#include "RefUsageMap.h"
+#include "OrgFeatureCache.h"
 
 using namespace std;
 
@@ -57,11 +77,224 @@ using namespace std;
 
 #include <math.h>
 #include <limits>
+#include <memory>
 
 
 //! \ingroup EncoderLib
 //! \{
 
+// CAROL: decisões de MTS da CTU atual, compartilhadas entre as estimativas de resíduo da mesma área
+static thread_local CAROL::MtsDecisionCache s_mtsDecisionCache;
+// CAROL: pirâmide de movimento por imagem, usada como preditor extra do xTZSearch
+static thread_local CAROL::MotionPyramid s_motionPyramid;
+// CAROL: campo de movimento 8x8 da CTU, compartilhado entre os tamanhos e partições de CU
+static thread_local CAROL::MotionFieldCache s_motionFieldCache;
+// CAROL: histórico de BVs da CTU do IBC (substitui m_ctuRecord)
+static thread_local CAROL::BvHistoryTable s_bvHistory;
+// CAROL: planos fracionários pré-calculados das referências e os da busca fracionária em curso
+static thread_local CAROL::SubPelPlanes s_subPelPlanes;
+static thread_local std::unique_ptr<CAROL::WorkerPool> s_subPelWorkerPool;
+static thread_local const CAROL::SubPelPlanes::Planes* s_activeSubPelPlanes = nullptr;
+static thread_local Position s_activeSubPelPos;   // bloco deslocado pelo vetor inteiro, em luma da imagem
+
+// CAROL: o xPatternRefinement lê dos planos enquanto o escopo existir
+struct SubPelPlanesScope
+{
+  SubPelPlanesScope(const CAROL::SubPelPlanes::Planes* planes, const Position& pos)
+  {
+    s_activeSubPelPlanes = planes;
+    s_activeSubPelPos    = pos;
+  }
+  ~SubPelPlanesScope() { s_activeSubPelPlanes = nullptr; }
+};
+
+// CAROL: SADs inteiros da última busca TZ e o modelo quadrático do refinamento fracionário em curso
+static thread_local CAROL::IntCostSurface s_intCostSurface;
+static thread_local const CAROL::IntCostSurface::Model* s_fracRefineModel = nullptr;
+
+struct FracRefineModelScope
+{
+  FracRefineModelScope(const CAROL::IntCostSurface::Model* model) { s_fracRefineModel = model; }
+  ~FracRefineModelScope() { s_fracRefineModel = nullptr; }
+};
+
+// CAROL: pontos do padrão TZ em avaliação (quadrado ou diamante)
+static thread_local CAROL::TZSadBatch s_tzSadBatch;
+
+// Calcula os SADs do lote de uma vez quando o xTZSearchHelp usaria o SAD simples do distFunc
+static void evaluateTZSadBatch(const IntTZSearchStruct& rcStruct, const DistParam& distParam)
+{
+  CAROL::SpeedupStats::getInstance().add(CAROL::StatId::TZ_BATCH_CANDIDATES, s_tzSadBatch.size());
+  if (rcStruct.subShiftMode != 1 && !distParam.applyWeight && s_tzSadBatch.size() > 1)
+  {
+    s_tzSadBatch.evaluate(*rcStruct.pcPatternKey, rcStruct.piRefY, rcStruct.iRefStride, distParam.subShift,
+                          distParam.bitDepth);
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::TZ_BATCH_EVALUATED, s_tzSadBatch.size());
+  }
+}
+
+// CAROL: modelos afins convergidos da CTU em grade 8x8; com o escopo ativo, o xAffineMotionEstimation
+// só avalia o ponto inicial (modelo herdado que já explica o bloco)
+static thread_local CAROL::AffineModelIndex s_affineModelIndex;
+static thread_local bool s_affineSkipIterations = false;
+
+struct AffineSkipIterationsScope
+{
+  AffineSkipIterationsScope(bool skip) { s_affineSkipIterations = skip; }
+  ~AffineSkipIterationsScope() { s_affineSkipIterations = false; }
+};
+
+// Vetores de controle do PU pelo modelo de 4 parâmetros nbMv de um bloco em (x, y) com largura w
+static void inheritAffineModel(const PredictionUnit& pu, int x, int y, int w, const Mv nbMv[2], Mv mvTmp[3])
+{
+  const int shift = MAX_CU_DEPTH;
+  int vx, vy;
+  int dMvHorX, dMvHorY, dMvVerX, dMvVerY;
+  int mvScaleHor = nbMv[0].getHor() * (1 << shift);
+  int mvScaleVer = nbMv[0].getVer() * (1 << shift);
+  Mv dMv = nbMv[1] - nbMv[0];
+
+  dMvHorX = dMv.getHor() * (1 << (shift - floorLog2(w)));
+  dMvHorY = dMv.getVer() * (1 << (shift - floorLog2(w)));
+  dMvVerX = -dMvHorY;
+  dMvVerY = dMvHorX;
+
+  vx = mvScaleHor + dMvHorX * (pu.Y().x - x) + dMvVerX * (pu.Y().y - y);
+  vy = mvScaleVer + dMvHorY * (pu.Y().x - x) + dMvVerY * (pu.Y().y - y);
+
+  mvTmp[0] = Mv(vx, vy);
+  mvTmp[0] >>= shift;
+  mvTmp[0].clipToStorageBitDepth();
+  clipMv( mvTmp[0], pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+  mvTmp[0].roundAffinePrecInternal2Amvr(pu.cu->imv);
+
+  vx = mvScaleHor + dMvHorX * (pu.Y().x + pu.Y().width - x) + dMvVerX * (pu.Y().y - y);
+  vy = mvScaleVer + dMvHorY * (pu.Y().x + pu.Y().width - x) + dMvVerY * (pu.Y().y - y);
+
+  mvTmp[1] = Mv(vx, vy);
+  mvTmp[1] >>= shift;
+  mvTmp[1].clipToStorageBitDepth();
+  clipMv(mvTmp[1], pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps);
+  mvTmp[1].roundAffinePrecInternal2Amvr(pu.cu->imv);
+}
+
+// CAROL: pré-teste da busca afim. Vetores inteiros dos quatro quadrantes do PU no campo de movimento da CTU
+// (só de buscas em blocos menores que o PU), na referência da melhor predição translacional; falso quando o
+// que o modelo de 4 parâmetros explicaria além da translação fica abaixo de th amostras. Sem dados: verdadeiro.
+static bool isAffineLikely(const PredictionUnit& pu, double th)
+{
+  const RefPicList eRefPicList = (pu.interDir & 1) ? REF_PIC_LIST_0 : REF_PIC_LIST_1;
+  const int        refIdx      = pu.refIdx[eRefPicList];
+  if (refIdx < 0)
+  {
+    return true;
+  }
+
+  s_motionFieldCache.enterCtu(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), pu.cs->pcv->maxCUWidth);
+  const int halfWidth  = pu.Y().width >> 1;
+  const int halfHeight = pu.Y().height >> 1;
+  int mvHor[4], mvVer[4];
+  for (int i = 0; i < 4; i++)
+  {
+    const Area quadrant(pu.Y().x + (i & 1) * halfWidth, pu.Y().y + (i >> 1) * halfHeight, halfWidth, halfHeight);
+    CAROL::MotionFieldCache::Cell cell;
+    if (!s_motionFieldCache.getBestFromSmaller(eRefPicList, refIdx, quadrant, pu.Y().area(), cell))
+    {
+      return true;
+    }
+    mvHor[i] = cell.hor;
+    mvVer[i] = cell.ver;
+  }
+  return CAROL::AffineLikelihood::fit(mvHor, mvVer, pu.Y().width, pu.Y().height).affinePart >= th;
+}
+
+// CAROL: SSE org - pred do CU em somas de prefixo, para as distorções das partes do SBT
+static thread_local CAROL::SbtDistortionMap s_sbtDistMap;
+
+// CAROL: predições e distorções dos pares simétricos já avaliados na busca SMVD do PU
+static thread_local CAROL::SymmetricPredCache s_symmetricPredCache;
+
+// CAROL: índice de hash dos blocos reconstruídos das CTUs à esquerda, na linha de CTUs da busca IBC
+static thread_local CAROL::IbcHashIndex s_ibcHashIndex;
+
+// CAROL: vetores de bloco cujo canto superior esquerdo k x k (k = 16, 8 ou 4) do original coincide com um
+// bloco indexado; o restante do PU fica para o SAD
+static int findIbcHashCandidates(const PredictionUnit& pu, const CPelBuf& pattern, Mv bvs[CAROL::IbcHashIndex::MAX_MATCHES])
+{
+  const int lcuWidth    = pu.cs->pcv->maxCUWidth;
+  const int ctuSizeLog2 = floorLog2(lcuWidth);
+  const int numLeftCtus = (1 << ((7 - ctuSizeLog2) << 1)) - ((ctuSizeLog2 < 7) ? 1 : 0);
+  s_ibcHashIndex.update(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), lcuWidth, numLeftCtus,
+                        pu.cu->slice->getPic()->getRecoBuf(COMPONENT_Y));
+
+  const int minSize = std::min<int>(pu.lwidth(), pu.lheight());
+  if (minSize < (1 << CAROL::IbcHashIndex::MIN_LOG2_SIZE))
+  {
+    return 0;
+  }
+  const int log2Size = std::min(floorLog2(minSize), CAROL::IbcHashIndex::MAX_LOG2_SIZE);
+  const uint32_t hash = CAROL::IbcHashIndex::hashBlock(pattern.buf, pattern.stride, log2Size);
+
+  Position  matches[CAROL::IbcHashIndex::MAX_MATCHES];
+  const int numMatches = s_ibcHashIndex.lookup(log2Size, hash, matches);
+  for (int i = 0; i < numMatches; i++)
+  {
+    bvs[i].set(matches[i].x - pu.Y().x, matches[i].y - pu.Y().y);
+  }
+  return numMatches;
+}
+
+// CAROL: refIdx escolhidos em cada CTU da imagem, para ordenar o teste das referências
+static thread_local CAROL::RefUsageMap s_refUsageMap;
+
+static void enterRefUsagePicture(const PredictionUnit& pu)
+{
+  s_refUsageMap.enterPicture(pu.cu->slice->getPOC(), pu.cs->picture->layerId, CAROL::CtuTag::currentInstance(),
+                             pu.cs->pcv->widthInCtus, pu.cs->pcv->heightInCtus);
+}
+
+// CAROL: ordem de teste dos refIdx da lista: votos das CTUs atual, esquerda e acima, depois distância de POC
+static void rankReferences(const PredictionUnit& pu, RefPicList eRefPicList, int order[MAX_NUM_REF])
+{
+  const Slice& slice  = *pu.cu->slice;
+  const int    numRef = slice.getNumRefIdx(eRefPicList);
+  int          pocDist[MAX_NUM_REF];
+  for (int i = 0; i < numRef; i++)
+  {
+    pocDist[i] = std::abs(slice.getPOC() - slice.getRefPic(eRefPicList, i)->getPOC());
+  }
+  enterRefUsagePicture(pu);
+  const CAROL::CtuTag tag = CAROL::CtuTag::of(*pu.cs, pu.lumaPos());
+  s_refUsageMap.rank(tag.ctuX, tag.ctuY, eRefPicList, numRef, pocDist, order);
+}
+
+// CAROL: voto das referências escolhidas pelo PU
+static void recordReferences(const PredictionUnit& pu)
+{
+  enterRefUsagePicture(pu);
+  const CAROL::CtuTag tag = CAROL::CtuTag::of(*pu.cs, pu.lumaPos());
+  for (int l = 0; l < NUM_REF_PIC_LIST_01; l++)
+  {
+    if (pu.interDir & (1 << l))
+    {
+      s_refUsageMap.record(tag.ctuX, tag.ctuY, l, pu.refIdx[l]);
+    }
+  }
+}
+
+// CAROL: (lista, refIdx) com ME uni-direcional no PU atual; as puladas pelo término antecipado ficam com o
+// preditor, que não pode servir de resultado de ME (lista de MVs uni, sementes do afim e do SMVD)
+static thread_local bool s_refMeSearched[NUM_REF_PIC_LIST_01][MAX_NUM_REF];
+
+// Dono da superfície: bloco, tamanho, lista, refIdx, bi-pred e POC
+static uint64_t intCostSurfaceOwner(const PredictionUnit& pu, RefPicList eRefPicList, int refIdx, bool biPred)
+{
+  return ((uint64_t)(pu.lx() & 0xffff)) | ((uint64_t)(pu.ly() & 0xffff) << 16)
+       | ((uint64_t)((pu.lwidth() - 1) & 0xff) << 32) | ((uint64_t)((pu.lheight() - 1) & 0xff) << 40)
+       | ((uint64_t)eRefPicList << 48) | ((uint64_t)(refIdx & 0x1f) << 49) | ((uint64_t)biPred << 54)
+       | ((uint64_t)(pu.cs->slice->getPOC() & 0x1ff) << 55);
+}
+
 static const Mv s_acMvRefineH[9] =
 {
   Mv(  0,  0 ), // 0
@@ -412,7 +645,15 @@ inline void InterSearch::xTZSearchHelp( IntTZSearchStruct& rcStruct, const int i
   }
   else
   {
-    uiSad = m_cDistParam.distFunc( m_cDistParam );
+    // CAROL: o SAD pode já ter sido calculado junto com os demais pontos do padrão
+    if (!m_pcEncCfg->CAROL_getBatchedTzSad() || !s_tzSadBatch.take(iSearchX, iSearchY, uiSad))
+    {
+      uiSad = m_cDistParam.distFunc( m_cDistParam );
+    }
+    if (s_intCostSurface.isActive())
+    {
+      s_intCostSurface.record(iSearchX, iSearchY, uiSad);
+    }
 
     // only add motion cost if uiSad is smaller than best. Otherwise pointless
     // to add motion cost.
@@ -478,42 +719,68 @@ inline void InterSearch::xTZ8PointSquareSearch( IntTZSearchStruct& rcStruct, con
   const int iRight      = iStartX + iDist;
   rcStruct.uiBestRound += 1;
 
+  // CAROL: com o lote ligado os pontos do padrão são só anotados e avaliados juntos no fim; desligado, cada
+  // ponto vai direto ao xTZSearchHelp
+  const bool batched     = m_pcEncCfg->CAROL_getBatchedTzSad();
+  auto       searchPoint = [&](int iX, int iY, uint8_t ucPointNr, uint32_t uiDistance)
+  {
+    if (batched)
+    {
+      s_tzSadBatch.add(iX, iY, ucPointNr, uiDistance);
+    }
+    else
+    {
+      xTZSearchHelp(rcStruct, iX, iY, ucPointNr, uiDistance);
+    }
+  };
+
   if ( iTop >= sr.top ) // check top
   {
     if ( iLeft >= sr.left ) // check top left
     {
-      xTZSearchHelp( rcStruct, iLeft, iTop, 1, iDist );
+      searchPoint( iLeft, iTop, 1, iDist );
     }
     // top middle
-    xTZSearchHelp( rcStruct, iStartX, iTop, 2, iDist );
+    searchPoint( iStartX, iTop, 2, iDist );
 
     if ( iRight <= sr.right ) // check top right
     {
-      xTZSearchHelp( rcStruct, iRight, iTop, 3, iDist );
+      searchPoint( iRight, iTop, 3, iDist );
     }
   } // check top
   if ( iLeft >= sr.left ) // check middle left
   {
-    xTZSearchHelp( rcStruct, iLeft, iStartY, 4, iDist );
+    searchPoint( iLeft, iStartY, 4, iDist );
   }
   if ( iRight <= sr.right ) // check middle right
   {
-    xTZSearchHelp( rcStruct, iRight, iStartY, 5, iDist );
+    searchPoint( iRight, iStartY, 5, iDist );
   }
   if ( iBottom <= sr.bottom ) // check bottom
   {
     if ( iLeft >= sr.left ) // check bottom left
     {
-      xTZSearchHelp( rcStruct, iLeft, iBottom, 6, iDist );
+      searchPoint( iLeft, iBottom, 6, iDist );
     }
     // check bottom middle
-    xTZSearchHelp( rcStruct, iStartX, iBottom, 7, iDist );
+    searchPoint( iStartX, iBottom, 7, iDist );
 
     if ( iRight <= sr.right ) // check bottom right
     {
-      xTZSearchHelp( rcStruct, iRight, iBottom, 8, iDist );
+      searchPoint( iRight, iBottom, 8, iDist );
     }
   } // check bottom
+
+  // CAROL: SADs do padrão avaliados juntos e consumidos na mesma ordem pelo xTZSearchHelp
+  if (batched)
+  {
+    evaluateTZSadBatch(rcStruct, m_cDistParam);
+    for (int i = 0; i < s_tzSadBatch.size(); i++)
+    {
+      xTZSearchHelp(rcStruct, s_tzSadBatch.x(i), s_tzSadBatch.y(i), s_tzSadBatch.pointNr(i), s_tzSadBatch.distance(i));
+    }
+    s_tzSadBatch.clear();
+  }
 }
 
 inline void InterSearch::xTZ8PointDiamondSearch( IntTZSearchStruct& rcStruct,
@@ -533,6 +800,21 @@ inline void InterSearch::xTZ8PointDiamondSearch( IntTZSearchStruct& rcStruct,
   const int iRight      = iStartX + iDist;
   rcStruct.uiBestRound += 1;
 
+  // CAROL: com o lote ligado os pontos do padrão são só anotados e avaliados juntos no fim; desligado, cada
+  // ponto vai direto ao xTZSearchHelp
+  const bool batched     = m_pcEncCfg->CAROL_getBatchedTzSad();
+  auto       searchPoint = [&](int iX, int iY, uint8_t ucPointNr, uint32_t uiDistance)
+  {
+    if (batched)
+    {
+      s_tzSadBatch.add(iX, iY, ucPointNr, uiDistance);
+    }
+    else
+    {
+      xTZSearchHelp(rcStruct, iX, iY, ucPointNr, uiDistance);
+    }
+  };
+
   if ( iDist == 1 )
   {
     if ( iTop >= sr.top ) // check top
@@ -541,26 +823,26 @@ inline void InterSearch::xTZ8PointDiamondSearch( IntTZSearchStruct& rcStruct,
       {
         if ( iLeft >= sr.left) // check top-left
         {
-          xTZSearchHelp( rcStruct, iLeft, iTop, 1, iDist );
+          searchPoint( iLeft, iTop, 1, iDist );
         }
-        xTZSearchHelp( rcStruct, iStartX, iTop, 2, iDist );
+        searchPoint( iStartX, iTop, 2, iDist );
         if ( iRight <= sr.right ) // check middle right
         {
-          xTZSearchHelp( rcStruct, iRight, iTop, 3, iDist );
+          searchPoint( iRight, iTop, 3, iDist );
         }
       }
       else
       {
-        xTZSearchHelp( rcStruct, iStartX, iTop, 2, iDist );
+        searchPoint( iStartX, iTop, 2, iDist );
       }
     }
     if ( iLeft >= sr.left ) // check middle left
     {
-      xTZSearchHelp( rcStruct, iLeft, iStartY, 4, iDist );
+      searchPoint( iLeft, iStartY, 4, iDist );
     }
     if ( iRight <= sr.right ) // check middle right
     {
-      xTZSearchHelp( rcStruct, iRight, iStartY, 5, iDist );
+      searchPoint( iRight, iStartY, 5, iDist );
     }
     if ( iBottom <= sr.bottom ) // check bottom
     {
@@ -568,17 +850,17 @@ inline void InterSearch::xTZ8PointDiamondSearch( IntTZSearchStruct& rcStruct,
       {
         if ( iLeft >= sr.left) // check top-left
         {
-          xTZSearchHelp( rcStruct, iLeft, iBottom, 6, iDist );
+          searchPoint( iLeft, iBottom, 6, iDist );
         }
-        xTZSearchHelp( rcStruct, iStartX, iBottom, 7, iDist );
+        searchPoint( iStartX, iBottom, 7, iDist );
         if ( iRight <= sr.right ) // check middle right
         {
-          xTZSearchHelp( rcStruct, iRight, iBottom, 8, iDist );
+          searchPoint( iRight, iBottom, 8, iDist );
         }
       }
       else
       {
-        xTZSearchHelp( rcStruct, iStartX, iBottom, 7, iDist );
+        searchPoint( iStartX, iBottom, 7, iDist );
       }
     }
   }
@@ -594,54 +876,54 @@ inline void InterSearch::xTZ8PointDiamondSearch( IntTZSearchStruct& rcStruct,
       if (  iTop >= sr.top && iLeft >= sr.left &&
            iRight <= sr.right && iBottom <= sr.bottom ) // check border
       {
-        xTZSearchHelp( rcStruct, iStartX,  iTop,      2, iDist    );
-        xTZSearchHelp( rcStruct, iLeft_2,  iTop_2,    1, iDist>>1 );
-        xTZSearchHelp( rcStruct, iRight_2, iTop_2,    3, iDist>>1 );
-        xTZSearchHelp( rcStruct, iLeft,    iStartY,   4, iDist    );
-        xTZSearchHelp( rcStruct, iRight,   iStartY,   5, iDist    );
-        xTZSearchHelp( rcStruct, iLeft_2,  iBottom_2, 6, iDist>>1 );
-        xTZSearchHelp( rcStruct, iRight_2, iBottom_2, 8, iDist>>1 );
-        xTZSearchHelp( rcStruct, iStartX,  iBottom,   7, iDist    );
+        searchPoint( iStartX,  iTop,      2, iDist    );
+        searchPoint( iLeft_2,  iTop_2,    1, iDist>>1 );
+        searchPoint( iRight_2, iTop_2,    3, iDist>>1 );
+        searchPoint( iLeft,    iStartY,   4, iDist    );
+        searchPoint( iRight,   iStartY,   5, iDist    );
+        searchPoint( iLeft_2,  iBottom_2, 6, iDist>>1 );
+        searchPoint( iRight_2, iBottom_2, 8, iDist>>1 );
+        searchPoint( iStartX,  iBottom,   7, iDist    );
       }
       else // check border
       {
         if ( iTop >= sr.top ) // check top
         {
-          xTZSearchHelp( rcStruct, iStartX, iTop, 2, iDist );
+          searchPoint( iStartX, iTop, 2, iDist );
         }
         if ( iTop_2 >= sr.top ) // check half top
         {
           if ( iLeft_2 >= sr.left ) // check half left
           {
-            xTZSearchHelp( rcStruct, iLeft_2, iTop_2, 1, (iDist>>1) );
+            searchPoint( iLeft_2, iTop_2, 1, (iDist>>1) );
           }
           if ( iRight_2 <= sr.right ) // check half right
           {
-            xTZSearchHelp( rcStruct, iRight_2, iTop_2, 3, (iDist>>1) );
+            searchPoint( iRight_2, iTop_2, 3, (iDist>>1) );
           }
         } // check half top
         if ( iLeft >= sr.left ) // check left
         {
-          xTZSearchHelp( rcStruct, iLeft, iStartY, 4, iDist );
+          searchPoint( iLeft, iStartY, 4, iDist );
         }
         if ( iRight <= sr.right ) // check right
         {
-          xTZSearchHelp( rcStruct, iRight, iStartY, 5, iDist );
+          searchPoint( iRight, iStartY, 5, iDist );
         }
         if ( iBottom_2 <= sr.bottom ) // check half bottom
         {
           if ( iLeft_2 >= sr.left ) // check half left
           {
-            xTZSearchHelp( rcStruct, iLeft_2, iBottom_2, 6, (iDist>>1) );
+            searchPoint( iLeft_2, iBottom_2, 6, (iDist>>1) );
           }
           if ( iRight_2 <= sr.right ) // check half right
           {
-            xTZSearchHelp( rcStruct, iRight_2, iBottom_2, 8, (iDist>>1) );
+            searchPoint( iRight_2, iBottom_2, 8, (iDist>>1) );
           }
         } // check half bottom
         if ( iBottom <= sr.bottom ) // check bottom
         {
-          xTZSearchHelp( rcStruct, iStartX, iBottom, 7, iDist );
+          searchPoint( iStartX, iBottom, 7, iDist );
         }
       } // check border
     }
@@ -650,39 +932,39 @@ inline void InterSearch::xTZ8PointDiamondSearch( IntTZSearchStruct& rcStruct,
       if ( iTop >= sr.top && iLeft >= sr.left &&
            iRight <= sr.right && iBottom <= sr.bottom ) // check border
       {
-        xTZSearchHelp( rcStruct, iStartX, iTop,    0, iDist );
-        xTZSearchHelp( rcStruct, iLeft,   iStartY, 0, iDist );
-        xTZSearchHelp( rcStruct, iRight,  iStartY, 0, iDist );
-        xTZSearchHelp( rcStruct, iStartX, iBottom, 0, iDist );
+        searchPoint( iStartX, iTop,    0, iDist );
+        searchPoint( iLeft,   iStartY, 0, iDist );
+        searchPoint( iRight,  iStartY, 0, iDist );
+        searchPoint( iStartX, iBottom, 0, iDist );
         for ( int index = 1; index < 4; index++ )
         {
           const int iPosYT = iTop    + ((iDist>>2) * index);
           const int iPosYB = iBottom - ((iDist>>2) * index);
           const int iPosXL = iStartX - ((iDist>>2) * index);
           const int iPosXR = iStartX + ((iDist>>2) * index);
-          xTZSearchHelp( rcStruct, iPosXL, iPosYT, 0, iDist );
-          xTZSearchHelp( rcStruct, iPosXR, iPosYT, 0, iDist );
-          xTZSearchHelp( rcStruct, iPosXL, iPosYB, 0, iDist );
-          xTZSearchHelp( rcStruct, iPosXR, iPosYB, 0, iDist );
+          searchPoint( iPosXL, iPosYT, 0, iDist );
+          searchPoint( iPosXR, iPosYT, 0, iDist );
+          searchPoint( iPosXL, iPosYB, 0, iDist );
+          searchPoint( iPosXR, iPosYB, 0, iDist );
         }
       }
       else // check border
       {
         if ( iTop >= sr.top ) // check top
         {
-          xTZSearchHelp( rcStruct, iStartX, iTop, 0, iDist );
+          searchPoint( iStartX, iTop, 0, iDist );
         }
         if ( iLeft >= sr.left ) // check left
         {
-          xTZSearchHelp( rcStruct, iLeft, iStartY, 0, iDist );
+          searchPoint( iLeft, iStartY, 0, iDist );
         }
         if ( iRight <= sr.right ) // check right
         {
-          xTZSearchHelp( rcStruct, iRight, iStartY, 0, iDist );
+          searchPoint( iRight, iStartY, 0, iDist );
         }
         if ( iBottom <= sr.bottom ) // check bottom
         {
-          xTZSearchHelp( rcStruct, iStartX, iBottom, 0, iDist );
+          searchPoint( iStartX, iBottom, 0, iDist );
         }
         for ( int index = 1; index < 4; index++ )
         {
@@ -695,28 +977,39 @@ inline void InterSearch::xTZ8PointDiamondSearch( IntTZSearchStruct& rcStruct,
           {
             if ( iPosXL >= sr.left ) // check left
             {
-              xTZSearchHelp( rcStruct, iPosXL, iPosYT, 0, iDist );
+              searchPoint( iPosXL, iPosYT, 0, iDist );
             }
             if ( iPosXR <= sr.right ) // check right
             {
-              xTZSearchHelp( rcStruct, iPosXR, iPosYT, 0, iDist );
+              searchPoint( iPosXR, iPosYT, 0, iDist );
             }
           } // check top
           if ( iPosYB <= sr.bottom ) // check bottom
           {
             if ( iPosXL >= sr.left ) // check left
             {
-              xTZSearchHelp( rcStruct, iPosXL, iPosYB, 0, iDist );
+              searchPoint( iPosXL, iPosYB, 0, iDist );
             }
             if ( iPosXR <= sr.right ) // check right
             {
-              xTZSearchHelp( rcStruct, iPosXR, iPosYB, 0, iDist );
+              searchPoint( iPosXR, iPosYB, 0, iDist );
             }
           } // check bottom
         } // for ...
       } // check border
     } // iDist <= 8
   } // iDist == 1
+
+  // CAROL: SADs do padrão avaliados juntos e consumidos na mesma ordem pelo xTZSearchHelp
+  if (batched)
+  {
+    evaluateTZSadBatch(rcStruct, m_cDistParam);
+    for (int i = 0; i < s_tzSadBatch.size(); i++)
+    {
+      xTZSearchHelp(rcStruct, s_tzSadBatch.x(i), s_tzSadBatch.y(i), s_tzSadBatch.pointNr(i), s_tzSadBatch.distance(i));
+    }
+    s_tzSadBatch.clear();
+  }
 }
 
 #if GDR_ENABLED
@@ -744,7 +1037,7 @@ Distortion InterSearch::xPatternRefinement( const CPelBuf* pcPatternKey,
   bool                   distBestOk       = false;
   bool allOk = true;
 #endif
-  Pel*  piRefPos;
+  const Pel* piRefPos;
   int iRefStride = pcPatternKey->width + 1;
   m_pcRdCost->setDistParam( m_cDistParam, *pcPatternKey, m_filteredBlock[0][0][0], iRefStride, m_lumaClpRng.bd, COMPONENT_Y, 0, 1, m_pcEncCfg->getUseHADME() && bAllowUseOfHadamard );
 
@@ -755,26 +1048,67 @@ Distortion InterSearch::xPatternRefinement( const CPelBuf* pcPatternKey,
     rbCleanCandExist = false;
   }
 #endif
-  for (uint32_t i = 0; i < 9; i++)
+
+  // CAROL: candidatos em ordem crescente de SAD previsto pelo modelo da superfície inteira; o centro
+  // (i = 0) calibra a escala entre o modelo e o custo real, e a busca para quando o limite inferior
+  // do próximo candidato já passa do melhor custo
+  uint32_t   order[9]     = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+  double     predicted[9] = { 0 };
+  double     modelScale   = 0;
+  const CAROL::IntCostSurface::Model* fracModel = s_fracRefineModel;
+#if GDR_ENABLED
+  if (isEncodeGdrClean)
   {
+    fracModel = nullptr;
+  }
+#endif
+  if (fracModel)
+  {
+    for (uint32_t i = 0; i < 9; i++)
+    {
+      Mv cMvTest = pcMvRefine[i];
+      cMvTest += baseRefMv;
+      predicted[i] = fracModel->at(cMvTest.getHor() * iFrac / 4.0, cMvTest.getVer() * iFrac / 4.0);
+    }
+    std::stable_sort(order + 1, order + 9, [&](uint32_t a, uint32_t b) { return predicted[a] < predicted[b]; });
+  }
+
+  for (uint32_t k = 0; k < 9; k++)
+  {
+    const uint32_t i = order[k];
     if (m_skipFracME && i > 0)
     {
       break;
     }
+    if (fracModel && k > 0 && m_pcEncCfg->CAROL_getPredictiveFracRefineBound() * modelScale * predicted[i] > distBest)
+    {
+      CAROL::SpeedupStats::getInstance().add(CAROL::StatId::FRAC_REFINE_SKIPPED, 9 - k);
+      break;
+    }
     Mv cMvTest = pcMvRefine[i];
     cMvTest += baseRefMv;
 
     int horVal = cMvTest.getHor() * iFrac;
     int verVal = cMvTest.getVer() * iFrac;
-    piRefPos = m_filteredBlock[verVal & 3][horVal & 3][0];
-
-    if (horVal == 2 && (verVal & 1) == 0)
+    if (s_activeSubPelPlanes)
     {
-      piRefPos += 1;
+      ptrdiff_t planeStride;
+      piRefPos = s_activeSubPelPlanes->at(horVal & 3, verVal & 3, s_activeSubPelPos.x + (horVal >> 2),
+                                          s_activeSubPelPos.y + (verVal >> 2), planeStride);
+      m_cDistParam.cur.stride = planeStride;
     }
-    if ((horVal & 1) == 0 && verVal == 2)
+    else
     {
-      piRefPos += iRefStride;
+      piRefPos = m_filteredBlock[verVal & 3][horVal & 3][0];
+
+      if (horVal == 2 && (verVal & 1) == 0)
+      {
+        piRefPos += 1;
+      }
+      if ((horVal & 1) == 0 && verVal == 2)
+      {
+        piRefPos += iRefStride;
+      }
     }
     cMvTest = pcMvRefine[i];
     cMvTest += rcMvFrac;
@@ -782,10 +1116,14 @@ Distortion InterSearch::xPatternRefinement( const CPelBuf* pcPatternKey,
 
     m_cDistParam.cur.buf   = piRefPos;
     dist                   = m_cDistParam.distFunc(m_cDistParam);
+    if (fracModel && k == 0)
+    {
+      modelScale = (double)dist / std::max(1.0, predicted[0]);
+    }
     dist += m_pcRdCost->getCostOfVectorWithPredictor(cMvTest.getHor(), cMvTest.getVer(), 0);
 
 #if GDR_ENABLED
-    allOk = (dist < distBest);
+    allOk = dist < distBest || (dist == distBest && i < directBest);
 
     if (isEncodeGdrClean)
     {
@@ -808,7 +1146,8 @@ Distortion InterSearch::xPatternRefinement( const CPelBuf* pcPatternKey,
 #if GDR_ENABLED
     if (allOk)
 #else
-    if (dist < distBest)
+    // fora de ordem (modo preditivo), o empate fica com o menor índice, como na ordem original
+    if (dist < distBest || (dist == distBest && i < directBest))
 #endif
     {
       distBest                                   = dist;
@@ -833,6 +1172,11 @@ Distortion InterSearch::xPatternRefinement( const CPelBuf* pcPatternKey,
 #endif
   }
 
+  if (fracModel && !m_skipFracME)
+  {
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::FRAC_REFINE_CANDIDATES, 9);
+  }
+
   rcMvFrac = pcMvRefine[directBest];
 
   return distBest;
@@ -1112,6 +1456,57 @@ void InterSearch::xIntraPatternSearch(PredictionUnit& pu, IntTZSearchStruct&  cS
       }
     }
 
+    // CAROL: candidatos do índice de hash; com uma cópia exata do bloco as varreduras são dispensadas
+    if (m_pcEncCfg->CAROL_getIbcRollingHash())
+    {
+      CAROL::SpeedupStats::getInstance().add(CAROL::StatId::IBC_HASH_LOOKUPS);
+      Mv        hashBvs[CAROL::IbcHashIndex::MAX_MATCHES];
+      const int numHashBvs = findIbcHashCandidates(pu, *cStruct.pcPatternKey, hashBvs);
+      bool      exactMatch = false;
+      for (int i = 0; i < numHashBvs; i++)
+      {
+        const int xPred = hashBvs[i].getHor();
+        const int yPred = hashBvs[i].getVer();
+        if ((yPred < srTop) || (yPred > srBottom) || (xPred < srLeft) || (xPred > srRight))
+        {
+          continue;
+        }
+        bool validCand =
+          isValidBv(pu, cuPelX, cuPelY, roiWidth, roiHeight, picWidth, picHeight, xPred, yPred, lcuWidth);
+#if GDR_ENABLED
+        if (isEncodeGdrClean)
+        {
+          Position BvBR(cuPelX + roiWidth + xPred - 1, cuPelY + roiHeight + yPred - 1);
+          validCand = validCand && cs.isClean(BvBR, ChannelType::LUMA);
+        }
+#endif
+        if (!validCand)
+        {
+          continue;
+        }
+        m_cDistParam.cur.buf  = piRefSrch + cStruct.iRefStride * yPred + xPred;
+        const Distortion dist = m_cDistParam.distFunc(m_cDistParam);
+        exactMatch |= dist == 0;
+        // os candidatos de m_acBVs já estão na lista
+        if (std::find(m_acBVs.begin(), m_acBVs.end(), hashBvs[i]) == m_acBVs.end())
+        {
+          sad = m_pcRdCost->getBvCostMultiplePreds(xPred, yPred, pu.cs->sps->getAMVREnabledFlag()) + dist;
+          xIBCSearchMVCandUpdate(sad, xPred, yPred, sadBestCand, cMVCand);
+        }
+      }
+      if (exactMatch)
+      {
+        CAROL::SpeedupStats::getInstance().add(CAROL::StatId::IBC_HASH_EXACT);
+        bestCandIdx = xIBCSearchMVChromaRefine(pu, roiWidth, roiHeight, cuPelX, cuPelY, sadBestCand, cMVCand);
+        bestX = cMVCand[bestCandIdx].getHor();
+        bestY = cMVCand[bestCandIdx].getVer();
+        sadBest = sadBestCand[bestCandIdx];
+        rcMv.set(bestX, bestY);
+        ruiCost = sadBest;
+        goto end;
+      }
+    }
+
     bestX = cMVCand[0].getHor();
     bestY = cMVCand[0].getVer();
     rcMv.set(bestX, bestY);
@@ -1398,13 +1793,14 @@ end:
   xMergeCandLists(m_defaultCachedBvs, cMVCand);
   xMergeCandLists(m_defaultCachedBvs, m_acBVs);
 
+  s_bvHistory.enterCtu(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), pu.cs->pcv->maxCUWidth);
   for (unsigned int cand = 0; cand < CHROMA_REFINEMENT_CANDIDATES; cand++)
   {
     if (cMVCand[cand].getHor() == 0 && cMVCand[cand].getVer() == 0)
     {
       continue;
     }
-    m_ctuRecord[pu.lumaPos()][pu.lumaSize()].bvRecord[cMVCand[cand]] = sadBestCand[cand];
+    s_bvHistory.record(pu.lumaPos(), pu.lumaSize(), cMVCand[cand].getHor(), cMVCand[cand].getVer(), sadBestCand[cand]);
   }
 
   return;
@@ -1477,13 +1873,9 @@ void InterSearch::xIBCEstimation(PredictionUnit& pu, PelUnitBuf& origBuf,
   if (m_pcEncCfg->getIBCFastMethod() & IBC_FAST_METHOD_BUFFERBV)
   {
     ruiCost = MAX_UINT;
-    std::unordered_map<Mv, Distortion>& history = m_ctuRecord[pu.lumaPos()][pu.lumaSize()].bvRecord;
-    for (std::unordered_map<Mv, Distortion>::iterator p = history.begin(); p != history.end(); p++)
-    {
-      const Mv& bv = p->first;
-
-      int xBv = bv.hor;
-      int yBv = bv.ver;
+    s_bvHistory.enterCtu(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), pu.cs->pcv->maxCUWidth);
+    s_bvHistory.forEach(pu.lumaPos(), pu.lumaSize(), [&](int xBv, int yBv, Distortion) {
+      const Mv bv(xBv, yBv);
 #if GDR_ENABLED
       bool validCand = true;
       if (isEncodeGdrClean)
@@ -1516,7 +1908,7 @@ void InterSearch::xIBCEstimation(PredictionUnit& pu, PelUnitBuf& origBuf,
           }
         }
       }
-    }
+    });
 
     if (buffered)
     {
@@ -1560,7 +1952,7 @@ void InterSearch::xIBCEstimation(PredictionUnit& pu, PelUnitBuf& origBuf,
             }
           }
 
-          m_ctuRecord[pu.lumaPos()][pu.lumaSize()].bvRecord[Mv(xPred, yPred)] = sad;
+          s_bvHistory.record(pu.lumaPos(), pu.lumaSize(), xPred, yPred, sad);
         }
       }
     }
@@ -1617,6 +2009,7 @@ void InterSearch::xSetIntraSearchRange(PredictionUnit& pu, int iRoiWidth, int iR
 
 bool InterSearch::predIBCSearch(CodingUnit& cu, Partitioner& partitioner, const int localSearchRangeX, const int localSearchRangeY, IbcHashMap& ibcHashMap)
 {
+  CAROL_BLOCK_TIMER(PRED_INTER_SEARCH, cu);
   Mv           cMvSrchRngLT;
   Mv           cMvSrchRngRB;
 
@@ -1866,80 +2259,90 @@ void InterSearch::xxIBCHashSearch(PredictionUnit& pu, Mv* mvPred, int numMvPred,
 }
 
 
-void InterSearch::addToSortList(std::list<BlockHash>& listBlockHash, std::list<int>& listCost, int cost, const BlockHash& blockHash)
+// CAROL: os N melhores candidatos do hash ME, ordenados por custo, num array fixo na pilha
+// (substitui o par de std::list de addToSortList; empates mantêm a ordem de chegada)
+template<int N>
+class HashMatchList
 {
-  std::list<BlockHash>::iterator itBlockHash = listBlockHash.begin();
-  std::list<int>::iterator itCost = listCost.begin();
-
-  while (itCost != listCost.end())
+public:
+  void insert(int cost, const BlockHash& blockHash)
   {
-    if (cost < (*itCost))
+    if (m_size == N && cost >= m_cost[N - 1])
     {
-      listCost.insert(itCost, cost);
-      listBlockHash.insert(itBlockHash, blockHash);
       return;
     }
-
-    ++itCost;
-    ++itBlockHash;
+    int i = m_size < N ? m_size++ : N - 1;
+    while (i > 0 && cost < m_cost[i - 1])
+    {
+      m_cost[i]      = m_cost[i - 1];
+      m_blockHash[i] = m_blockHash[i - 1];
+      i--;
+    }
+    m_cost[i]      = cost;
+    m_blockHash[i] = blockHash;
   }
 
-  listCost.push_back(cost);
-  listBlockHash.push_back(blockHash);
-}
+  int              size()  const { return m_size; }
+  bool             empty() const { return m_size == 0; }
+  const BlockHash* begin() const { return m_blockHash; }
+  const BlockHash* end()   const { return m_blockHash + m_size; }
 
-void InterSearch::selectMatchesInter(const MapIterator& itBegin, int count, std::list<BlockHash>& listBlockHash, const BlockHash& currBlockHash)
-{
-  const int maxReturnNumber = Hash::NUM_LOG_BLK_SIZES;
+private:
+  int       m_size = 0;
+  int       m_cost[N];
+  BlockHash m_blockHash[N];
+};
 
-  listBlockHash.clear();
-  std::list<int> listCost;
-  listCost.clear();
+static const int HASH_MATCHES_INTER      = Hash::NUM_LOG_BLK_SIZES;
+static const int HASH_RECT_MATCHES_INTER = 5;
 
-  MapIterator it = itBegin;
-  for (int i = 0; i < count; i++, it++)
+// Índices do bucket [itBegin, itBegin + count) com hashValue2 igual; compactação sem desvio por
+// blocos, para o teste (o caso comum: descarte) não depender do preditor de desvios
+template<typename Func>
+static void forEachHashValue2Match(const MapIterator& itBegin, int count, unsigned int hashValue2, Func func)
+{
+  static const int CHUNK = 64;
+  int matches[CHUNK];
+  for (int base = 0; base < count; base += CHUNK)
   {
-    if ((*it).hashValue2 != currBlockHash.hashValue2)
-    {
-      continue;
-    }
-
-    int currCost = RdCost::xGetExpGolombNumberOfBits((*it).x - currBlockHash.x) +
-      RdCost::xGetExpGolombNumberOfBits((*it).y - currBlockHash.y);
-
-    if (listBlockHash.size() < maxReturnNumber)
+    const int        num   = std::min(CHUNK, count - base);
+    const BlockHash* chunk = &(*(itBegin + base));
+    int              numMatches = 0;
+    for (int i = 0; i < num; i++)
     {
-      addToSortList(listBlockHash, listCost, currCost, (*it));
+      matches[numMatches] = i;
+      numMatches += chunk[i].hashValue2 == hashValue2;
     }
-    else if (!listCost.empty() && currCost < listCost.back())
+    for (int i = 0; i < numMatches; i++)
     {
-      listCost.pop_back();
-      listBlockHash.pop_back();
-      addToSortList(listBlockHash, listCost, currCost, (*it));
+      func(chunk[matches[i]]);
     }
   }
 }
-void InterSearch::selectRectangleMatchesInter(const MapIterator& itBegin, int count, std::list<BlockHash>& listBlockHash, const BlockHash& currBlockHash, int width, int height, int idxNonSimple, unsigned int* &hashValues, int baseNum, int picWidth, int picHeight, bool isHorizontal, uint16_t* curHashPic)
+
+static void selectHashMatchesInter(const MapIterator& itBegin, int count, HashMatchList<HASH_MATCHES_INTER>& listBlockHash,
+                                   const BlockHash& currBlockHash)
+{
+  forEachHashValue2Match(itBegin, count, currBlockHash.hashValue2, [&](const BlockHash& refBlockHash) {
+    int currCost = RdCost::xGetExpGolombNumberOfBits(refBlockHash.x - currBlockHash.x) +
+      RdCost::xGetExpGolombNumberOfBits(refBlockHash.y - currBlockHash.y);
+
+    listBlockHash.insert(currCost, refBlockHash);
+  });
+}
+
+static void selectRectangleHashMatchesInter(const MapIterator& itBegin, int count, HashMatchList<HASH_RECT_MATCHES_INTER>& listBlockHash,
+                                            const BlockHash& currBlockHash, int width, int height, int idxNonSimple,
+                                            unsigned int* hashValues, int baseNum, int picWidth, int picHeight,
+                                            bool isHorizontal, uint16_t* curHashPic)
 {
-  const int maxReturnNumber = 5;
   int          baseSize        = std::min(width, height);
   unsigned int crcMask = 1 << 16;
   crcMask -= 1;
 
-  listBlockHash.clear();
-  std::list<int> listCost;
-  listCost.clear();
-
-  MapIterator it = itBegin;
-
-  for (int i = 0; i < count; i++, it++)
-  {
-    if ((*it).hashValue2 != currBlockHash.hashValue2)
-    {
-      continue;
-    }
-    int xRef = (*it).x;
-    int yRef = (*it).y;
+  forEachHashValue2Match(itBegin, count, currBlockHash.hashValue2, [&](const BlockHash& matchBlockHash) {
+    int xRef = matchBlockHash.x;
+    int yRef = matchBlockHash.y;
     if (isHorizontal)
     {
       xRef -= idxNonSimple * baseSize;
@@ -1950,45 +2353,30 @@ void InterSearch::selectRectangleMatchesInter(const MapIterator& itBegin, int co
     }
     if (xRef < 0 || yRef < 0 || xRef + width >= picWidth || yRef + height >= picHeight)
     {
-      continue;
+      return;
     }
     //check Other baseSize hash values
     uint16_t* refHashValue = curHashPic + yRef * picWidth + xRef;
-    bool isSame = true;
 
     for (int k = 0; k < baseNum; k++)
     {
       if ((*refHashValue) != (uint16_t)(hashValues[k] & crcMask))
       {
-        isSame = false;
-        break;
+        return;
       }
       refHashValue += (isHorizontal ? baseSize : (baseSize*picWidth));
     }
-    if (!isSame)
-    {
-      continue;
-    }
 
     int currCost = RdCost::xGetExpGolombNumberOfBits(xRef - currBlockHash.x) +
       RdCost::xGetExpGolombNumberOfBits(yRef - currBlockHash.y);
 
     BlockHash refBlockHash;
-    refBlockHash.hashValue2 = (*it).hashValue2;
+    refBlockHash.hashValue2 = matchBlockHash.hashValue2;
     refBlockHash.x = xRef;
     refBlockHash.y = yRef;
 
-    if (listBlockHash.size() < maxReturnNumber)
-    {
-      addToSortList(listBlockHash, listCost, currCost, refBlockHash);
-    }
-    else if (!listCost.empty() && currCost < listCost.back())
-    {
-      listCost.pop_back();
-      listBlockHash.pop_back();
-      addToSortList(listBlockHash, listCost, currCost, refBlockHash);
-    }
-  }
+    listBlockHash.insert(currCost, refBlockHash);
+  });
 }
 
 bool InterSearch::xRectHashInterEstimation(PredictionUnit& pu, RefPicList& bestRefPicList, int& bestRefIndex, Mv& bestMv, Mv& bestMvd, int& bestMVPIndex, bool& isPerfectMatch)
@@ -2104,10 +2492,10 @@ bool InterSearch::xRectHashInterEstimation(PredictionUnit& pu, RefPicList& bestR
           continue;
         }
 
-        std::list<BlockHash> listBlockHash;
-        selectRectangleMatchesInter(pu.cu->slice->getRefPic(eRefPicList, refIdx)->getHashMap()->getFirstIterator(hashValue1s[idxNonSimple]), count, listBlockHash, currBlockHash, width, height, idxNonSimple, hashValue2s, baseNum, picWidth, picHeight, isHorizontal, pu.cu->slice->getRefPic(eRefPicList, refIdx)->getHashMap()->getHashPic(baseSize));
+        HashMatchList<HASH_RECT_MATCHES_INTER> listBlockHash;
+        selectRectangleHashMatchesInter(pu.cu->slice->getRefPic(eRefPicList, refIdx)->getHashMap()->getFirstIterator(hashValue1s[idxNonSimple]), count, listBlockHash, currBlockHash, width, height, idxNonSimple, hashValue2s, baseNum, picWidth, picHeight, isHorizontal, pu.cu->slice->getRefPic(eRefPicList, refIdx)->getHashMap()->getHashPic(baseSize));
 
-        m_numHashMVStoreds[eRefPicList][refIdx] = int(listBlockHash.size());
+        m_numHashMVStoreds[eRefPicList][refIdx] = listBlockHash.size();
         if (listBlockHash.empty())
         {
           continue;
@@ -2157,7 +2545,7 @@ bool InterSearch::xRectHashInterEstimation(PredictionUnit& pu, RefPicList& bestR
         m_pcRdCost->selectMotionLambda( );
         m_pcRdCost->setCostScale(0);
 
-        std::list<BlockHash>::iterator it;
+        const BlockHash* it;
         int countMV = 0;
         for (it = listBlockHash.begin(); it != listBlockHash.end(); ++it)
         {
@@ -2406,9 +2794,9 @@ bool InterSearch::xHashInterEstimation(PredictionUnit& pu, RefPicList& bestRefPi
           continue;
         }
 
-        std::list<BlockHash> listBlockHash;
-        selectMatchesInter(pu.cu->slice->getRefPic(eRefPicList, refIdx)->getHashMap()->getFirstIterator(hashValue1), count, listBlockHash, currBlockHash);
-        m_numHashMVStoreds[eRefPicList][refIdx] = (int)listBlockHash.size();
+        HashMatchList<HASH_MATCHES_INTER> listBlockHash;
+        selectHashMatchesInter(pu.cu->slice->getRefPic(eRefPicList, refIdx)->getHashMap()->getFirstIterator(hashValue1), count, listBlockHash, currBlockHash);
+        m_numHashMVStoreds[eRefPicList][refIdx] = listBlockHash.size();
         if (listBlockHash.empty())
         {
           continue;
@@ -2474,7 +2862,7 @@ bool InterSearch::xHashInterEstimation(PredictionUnit& pu, RefPicList& bestRefPi
         m_pcRdCost->selectMotionLambda( );
         m_pcRdCost->setCostScale(0);
 
-        std::list<BlockHash>::iterator it;
+        const BlockHash* it;
         int countMV = 0;
         for (it = listBlockHash.begin(); it != listBlockHash.end(); ++it)
         {
@@ -2648,6 +3036,7 @@ bool InterSearch::xHashInterEstimation(PredictionUnit& pu, RefPicList& bestRefPi
 
 bool InterSearch::predInterHashSearch(CodingUnit& cu, Partitioner& partitioner, bool& isPerfectMatch)
 {
+  CAROL_BLOCK_TIMER(PRED_INTER_SEARCH, cu, true, true);
   Mv       bestMv, bestMvd;
   RefPicList   bestRefPicList;
   int          bestRefIndex;
@@ -2693,6 +3082,8 @@ bool InterSearch::predInterHashSearch(CodingUnit& cu, Partitioner& partitioner,
 //! search of the best candidate for inter prediction
 void InterSearch::predInterSearch(CodingUnit& cu, Partitioner& partitioner)
 {
+  CAROL_SCOPED_TIMER(PRED_INTER_SEARCH);
+  CAROL_BLOCK_TIMER(PRED_INTER_SEARCH, cu);
   CodingStructure& cs = *cu.cs;
 
   AMVPInfo     amvp[NUM_REF_PIC_LIST_01];
@@ -2790,11 +3181,16 @@ cv::Mat blkWrapper(yBuf.height, yBuf.width, CV_16S, yBuf.buf, yBuf.stride * size
 cv::Mat resiWrapper(resiBuf.height, resiBuf.width, CV_16S, (void*)resiBuf.buf, resiBuf.stride * sizeof(Pel));
 
 // --- Extração de Features ---
-// Agora passando os dois wrappers conforme a nova assinatura
-BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
+// CAROL: as features do original vêm da cache compartilhada entre os QPs (modo multi-QP); as do resíduo, sempre daqui.
+// Com o filtro temporal do GOP o original do cs é o filtrado, cuja força depende do QP: cada codificador calcula as suas
+BlockFeatures feats = m_pcEncCfg->getGopBasedTemporalFilterEnabled()
+                        ? extract_org_features(blkWrapper)
+                        : CAROL::OrgFeatureCache::getInstance().get(m_pcEncCfg->CAROL_getInputFileName(), pu.cs->slice->getPOC(),
+                                                                    blk.x, blk.y, blk.width, blk.height, blkWrapper);
+feats.residual = extract_residual_features(resiWrapper);
   // Log das metade inicial
   auto& logger = CAROL::FeatureLogger::getInstance();
-  logger.init(m_pcEncCfg->CAROL_getInputFileName(), m_pcEncCfg->getBaseQP());
+  logger.init(m_pcEncCfg->CAROL_getInputFileName());
 
   // ------------ Chama startLine - primeira fase da captura ------------
   cu.carolKey = logger.startLine(pu, feats, m_pcEncCfg->getBaseQP());
@@ -2953,15 +3349,37 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
 
     m_pcRdCost->selectMotionLambda( );
 
+    // CAROL: término antecipado por referência: com o melhor custo uni-direcional da lista abaixo do
+    // limiar (bits por 4x4 ao lambda de movimento), as referências seguintes ficam só com o AMVP
+    const double refEarlyTermTh = m_pcEncCfg->CAROL_getRefEarlyTermTh();
+    bool         refEarlyTerm   = refEarlyTermTh > 0;
+#if GDR_ENABLED
+    refEarlyTerm = refEarlyTerm && !isEncodeGdrClean;
+#endif
+    const Distortion refEarlyTermCost =
+      refEarlyTerm ? m_pcRdCost->getCost((uint32_t)(refEarlyTermTh * (pu.Y().area() >> 4))) : 0;
+
     unsigned imvShift = pu.cu->imv == IMV_HPEL ? 1 : (pu.cu->imv << 1);
+    std::fill(&s_refMeSearched[0][0], &s_refMeSearched[0][0] + NUM_REF_PIC_LIST_01 * MAX_NUM_REF, true);
+    bool allRefsSearched = true;
     if ( checkNonAffine )
     {
       //  Uni-directional prediction
       for (int refList = 0; refList < iNumPredDir; refList++)
       {
         RefPicList eRefPicList = (refList ? REF_PIC_LIST_1 : REF_PIC_LIST_0);
-        for (int refIdxTemp = 0; refIdxTemp < cs.slice->getNumRefIdx(eRefPicList); refIdxTemp++)
+        int        refOrder[MAX_NUM_REF];
+        for (int i = 0; i < MAX_NUM_REF; i++)
+        {
+          refOrder[i] = i;
+        }
+        if (refEarlyTerm)
         {
+          rankReferences(pu, eRefPicList, refOrder);
+        }
+        for (int refOrderIdx = 0; refOrderIdx < cs.slice->getNumRefIdx(eRefPicList); refOrderIdx++)
+        {
+          const int refIdxTemp = refOrder[refOrderIdx];
           bitsTemp = mbBits[refList];
           if ( cs.slice->getNumRefIdx(eRefPicList) > 1 )
           {
@@ -3024,9 +3442,31 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
 
           bitsTemp += m_auiMVPIdxCost[aaiMvpIdx[refList][refIdxTemp]][AMVP_MAX_NUM_CANDS];
 
+          if (refEarlyTerm)
+          {
+            CAROL::SpeedupStats::getInstance().add(CAROL::StatId::REF_ME_TESTED);
+            if (uiCost[refList] < refEarlyTermCost)
+            {
+              // a referência fica com o preditor, fora da decisão uni-direcional; o bi-pred ainda a considera
+              CAROL::SpeedupStats::getInstance().add(CAROL::StatId::REF_ME_SKIPPED);
+              s_refMeSearched[refList][refIdxTemp] = false;
+              allRefsSearched                      = false;
+              cMvTemp[refList][refIdxTemp] = cMvPred[refList][refIdxTemp];
+              xCopyAMVPInfo(&amvp[eRefPicList], &aacAMVPInfo[refList][refIdxTemp]);
+              if (refList == 0)
+              {
+                uiCostTempL0[refIdxTemp] = std::numeric_limits<Distortion>::max();
+                uiBitsTempL0[refIdxTemp] = bitsTemp;
+              }
+              continue;
+            }
+          }
+
           if (m_pcEncCfg->getFastMEForGenBLowDelayEnabled() && refList == 1)   // list 1
           {
-            if (cs.slice->getList1IdxToList0Idx(refIdxTemp) >= 0)
+            // CAROL: a referência da lista 0 pulada pelo término antecipado não tem custo para reaproveitar
+            if (cs.slice->getList1IdxToList0Idx(refIdxTemp) >= 0
+                && uiCostTempL0[cs.slice->getList1IdxToList0Idx(refIdxTemp)] != std::numeric_limits<Distortion>::max())
             {
               cMvTemp[1][refIdxTemp] = cMvTemp[0][cs.slice->getList1IdxToList0Idx(refIdxTemp)];
 #if GDR_ENABLED
@@ -3264,7 +3704,9 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
         ::memcpy(cMvHevcTempValid, cMvTempValid, sizeof(cMvTempValid));
       }
 #endif
-      if (cu.imv == 0 && (!cu.slice->getSPS()->getUseBcw() || bcwIdx == BCW_DEFAULT))
+      // CAROL: os registros de MVs uni guardam todas as referências do bloco, sem marcar as não buscadas: com
+      // alguma referência pulada o bloco não entra na lista nem no reaproveitamento
+      if (cu.imv == 0 && (!cu.slice->getSPS()->getUseBcw() || bcwIdx == BCW_DEFAULT) && allRefsSearched)
       {
         insertUniMvCands(pu.Y(), cMvTemp);
 
@@ -3397,10 +3839,15 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
             numIter = 1;
           }
 
+          // CAROL: modo adaptativo, as iterações param quando o custo ou o vetor deixam de mudar
+          const bool adaptiveIter = m_pcEncCfg->CAROL_getBiPredAdaptiveIter() && numIter > 1;
+          int        itersDone    = 0;
+
           enforceBcwPred = (bcwIdx != BCW_DEFAULT);
           for (int iter = 0; iter < numIter; iter++)
           {
             int refList = iter % 2;
+            itersDone++;
 
             if (m_pcEncCfg->getFastInterSearchMode() == FASTINTERSEARCH_MODE1
                 || m_pcEncCfg->getFastInterSearchMode() == FASTINTERSEARCH_MODE2)
@@ -3467,6 +3914,9 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
             }
 
             bool changed = false;
+            const Distortion costBiPrev   = costBi;
+            const Mv         mvBiPrev     = cMvBi[refList];
+            const int        refIdxBiPrev = iRefIdxBi[refList];
 
             iRefStart = 0;
             iRefEnd   = cs.slice->getNumRefIdx(eRefPicList) - 1;
@@ -3615,6 +4065,14 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
               }
             }   // for loop-refIdxTemp
 
+            // CAROL: ganho relativo abaixo do epsilon ou mesmo vetor/referência encerram como se nada mudasse
+            if (changed && adaptiveIter
+                && ((double) (costBiPrev - costBi) < m_pcEncCfg->CAROL_getBiPredIterEpsilon() * (double) costBiPrev
+                    || (cMvBi[refList] == mvBiPrev && iRefIdxBi[refList] == refIdxBiPrev)))
+            {
+              changed = false;
+            }
+
             if (!changed)
             {
 #if GDR_ENABLED
@@ -3697,6 +4155,11 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
               break;
             }
           }   // for loop-iter
+
+          if (adaptiveIter)
+          {
+            CAROL::SpeedupStats::getInstance().addBiPredIterations(pu.lwidth(), pu.lheight(), itersDone);
+          }
         }
         cu.refIdxBi[0] = iRefIdxBi[0];
         cu.refIdxBi[1] = iRefIdxBi[1];
@@ -3723,6 +4186,8 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
             aacAMVPInfo[tarRefList][refIdxTar].numCand = 1;
           }
 
+          CAROL::SymmetricPredCache::Scope symmetricPredScope(s_symmetricPredCache, m_pcEncCfg->CAROL_getSmvdPredCache(),
+                                                              pu.lwidth(), pu.lheight());
           MvField cCurMvField, cTarMvField;
           Distortion costStart = std::numeric_limits<Distortion>::max();
 
@@ -3840,8 +4305,11 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
             }
           };
 
-          smmvdCandsGen(cMvHevcTemp[curRefList][refIdxCur], false);
-          smmvdCandsGen(cMvTemp[curRefList][refIdxCur], false);
+          if (s_refMeSearched[curRefList][refIdxCur])
+          {
+            smmvdCandsGen(cMvHevcTemp[curRefList][refIdxCur], false);
+            smmvdCandsGen(cMvTemp[curRefList][refIdxCur], false);
+          }
           if (iRefIdxBi[curRefList] == refIdxCur)
           {
             smmvdCandsGen(cMvBi[curRefList], false);
@@ -4224,6 +4692,18 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
 #endif
     }
 
+    // CAROL: sem busca afim quando a translação já descreve o movimento dos quadrantes
+    if (m_pcEncCfg->CAROL_getAffinePreTestTh() > 0 && checkAffine && cu.Y().width > 8 && cu.Y().height > 8
+        && cu.slice->getSPS()->getUseAffine() && m_pcEncCfg->getUseAffineAmvp())
+    {
+      CAROL::SpeedupStats::getInstance().add(CAROL::StatId::AFFINE_PRETEST_CHECKED);
+      if (!isAffineLikely(pu, m_pcEncCfg->CAROL_getAffinePreTestTh()))
+      {
+        CAROL::SpeedupStats::getInstance().add(CAROL::StatId::AFFINE_PRETEST_SKIPPED);
+        checkAffine = false;
+      }
+    }
+
     if (cu.Y().width > 8 && cu.Y().height > 8 && cu.slice->getSPS()->getUseAffine()
       && checkAffine
       && m_pcEncCfg->getUseAffineAmvp()
@@ -4591,6 +5071,11 @@ BlockFeatures feats = extract_block_features(blkWrapper, resiWrapper);
       }
     }
     motionCompensation( pu, predBuf, REF_PIC_LIST_X );
+
+    if (m_pcEncCfg->CAROL_getRefEarlyTermTh() > 0)
+    {
+      recordReferences(pu);
+    }
     puIdx++;
   }
   //PelUnitBuf origBuf = pu.cs->getOrgBuf( pu );
@@ -4967,6 +5452,7 @@ void InterSearch::xMotionEstimation(PredictionUnit &pu, PelUnitBuf &origBuf, Ref
                                     const AMVPInfo &amvpInfo, bool bBi)
 #endif
 {
+  CAROL_SCOPED_TIMER(MOTION_ESTIMATION);
 #if GDR_ENABLED
   if (pu.cu->cs->sps->getUseBcw() && pu.cu->bcwIdx != BCW_DEFAULT && !bBi
       && xReadBufferedUniMv(pu, eRefPicList, refIdxPred, rcMvPred, rcMv, rcMvSolid, ruiBits, ruiCost))
@@ -5382,6 +5868,7 @@ void InterSearch::xTZSearch(const PredictionUnit &pu, RefPicList eRefPicList, in
                             IntTZSearchStruct &cStruct, Mv &rcMv, Distortion &ruiSAD,
                             const Mv *const pIntegerMv2Nx2NPred, const bool bExtendedSettings, const bool bFastSettings)
 {
+  CAROL_SCOPED_TIMER(TZ_SEARCH);
   const bool bUseRasterInFastMode                    = true; //toggle this to further reduce runtime
 
   const bool bUseAdaptiveRaster                      = bExtendedSettings;
@@ -5430,6 +5917,11 @@ void InterSearch::xTZSearch(const PredictionUnit &pu, RefPicList eRefPicList, in
   m_cDistParam.maximumDistortionForEarlyExit = cStruct.uiBestSad;
   m_pcRdCost->setDistParam( m_cDistParam, *cStruct.pcPatternKey, cStruct.piRefY, cStruct.iRefStride, m_lumaClpRng.bd, COMPONENT_Y, cStruct.subShiftMode );
 
+  // CAROL: superfície de custo inteira para o refinamento fracionário preditivo e o ajuste sub-pel
+  CAROL::IntCostSurface::Scope intCostSurfaceScope(s_intCostSurface,
+                                                   m_pcEncCfg->CAROL_getPredictiveFracRefine() || m_pcEncCfg->CAROL_getSubPelFit(),
+                                                   intCostSurfaceOwner(pu, eRefPicList, refIdxPred, m_cDistParam.isBiPred));
+
   // distortion
 
 
@@ -5537,6 +6029,56 @@ void InterSearch::xTZSearch(const PredictionUnit &pu, RefPicList eRefPicList, in
 #endif
   }
 
+  // CAROL: vetor da busca hierárquica da CTU como candidato inicial adicional
+  bool pyramidAvailable = false;
+  CAROL::MotionPyramid::CtuMv pyramidMv;
+  if (m_pcEncCfg->CAROL_getMotionPyramid() && !cStruct.inCtuSearch)
+  {
+    const int ctuSizeLog2 = floorLog2(pu.cs->pcv->maxCUWidth);
+    pyramidAvailable = s_motionPyramid.getCtuMv(*pu.cs->picture, *pu.cu->slice->getRefPic(eRefPicList, refIdxPred),
+                                                pu.lx() >> ctuSizeLog2, pu.ly() >> ctuSizeLog2,
+                                                pu.cs->pcv->maxCUWidth, m_searchRange, pyramidMv);
+    if (pyramidAvailable)
+    {
+      Mv cTmpMv(pyramidMv.hor, pyramidMv.ver);
+      cTmpMv.changePrecision(MvPrecision::ONE, MvPrecision::INTERNAL);
+      clipMv( cTmpMv, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+      cTmpMv.changePrecision(MvPrecision::INTERNAL, MvPrecision::ONE);
+      pyramidMv.hor = cTmpMv.getHor();
+      pyramidMv.ver = cTmpMv.getVer();
+      if (pyramidMv.hor != cStruct.iBestX || pyramidMv.ver != cStruct.iBestY)
+      {
+        xTZSearchHelp( cStruct, pyramidMv.hor, pyramidMv.ver, 0, 0 );
+      }
+    }
+  }
+
+  // CAROL: vetores já encontrados por outras CUs da CTU que cobrem a mesma região
+  const bool useMotionField = m_pcEncCfg->CAROL_getMotionFieldCache() && !m_cDistParam.isBiPred && !cStruct.inCtuSearch;
+  // o pré-teste afim lê o campo mesmo sem as sementes
+  const bool storeMotionField = (useMotionField || m_pcEncCfg->CAROL_getAffinePreTestTh() > 0) && !m_cDistParam.isBiPred
+                                && !cStruct.inCtuSearch;
+  CAROL::MotionFieldCache::Cell fieldSeeds[CAROL::MotionFieldCache::MAX_SEEDS];
+  int numFieldSeeds = 0;
+  if (useMotionField)
+  {
+    s_motionFieldCache.enterCtu(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), pu.cs->pcv->maxCUWidth);
+    numFieldSeeds = s_motionFieldCache.getSeeds(eRefPicList, refIdxPred, pu.Y(), fieldSeeds);
+    for (int i = 0; i < numFieldSeeds; i++)
+    {
+      Mv cTmpMv(fieldSeeds[i].hor, fieldSeeds[i].ver);
+      cTmpMv.changePrecision(MvPrecision::ONE, MvPrecision::INTERNAL);
+      clipMv( cTmpMv, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+      cTmpMv.changePrecision(MvPrecision::INTERNAL, MvPrecision::ONE);
+      fieldSeeds[i].hor = cTmpMv.getHor();
+      fieldSeeds[i].ver = cTmpMv.getVer();
+      if (fieldSeeds[i].hor != cStruct.iBestX || fieldSeeds[i].ver != cStruct.iBestY)
+      {
+        xTZSearchHelp( cStruct, fieldSeeds[i].hor, fieldSeeds[i].ver, 0, 0 );
+      }
+    }
+  }
+
   {
     // set search range
     Mv currBestMv(cStruct.iBestX, cStruct.iBestY );
@@ -5640,8 +6182,31 @@ void InterSearch::xTZSearch(const PredictionUnit &pu, RefPicList eRefPicList, in
     xTZ2PointSearch( cStruct );
   }
 
+  // CAROL: pula o raster quando a pirâmide é confiável (casamento bom e busca inicial convergindo para ele)
+  bool skipRaster = false;
+  if (pyramidAvailable)
+  {
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::PYRAMID_SEARCHES);
+    skipRaster = pyramidMv.sadPerSample <= m_pcEncCfg->CAROL_getMotionPyramidSadTh()
+                 && abs(cStruct.iBestX - pyramidMv.hor) < iRaster && abs(cStruct.iBestY - pyramidMv.ver) < iRaster;
+    if (skipRaster)
+    {
+      CAROL::SpeedupStats::getInstance().add(CAROL::StatId::PYRAMID_RASTER_SKIPPED);
+    }
+  }
+  // CAROL: a busca inicial confirmou o melhor vetor do campo da CTU -> dispensa o raster
+  if (numFieldSeeds > 0)
+  {
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::MOTION_FIELD_SEEDED);
+    if (!skipRaster && cStruct.iBestX == fieldSeeds[0].hor && cStruct.iBestY == fieldSeeds[0].ver)
+    {
+      skipRaster = true;
+      CAROL::SpeedupStats::getInstance().add(CAROL::StatId::MOTION_FIELD_PRUNED);
+    }
+  }
+
   // raster search if distance is too big
-  if (bUseAdaptiveRaster)
+  if (bUseAdaptiveRaster && !skipRaster)
   {
     int iWindowSize     = iRaster;
     SearchRange localsr = sr;
@@ -5665,7 +6230,7 @@ void InterSearch::xTZSearch(const PredictionUnit &pu, RefPicList eRefPicList, in
   }
   else
   {
-    if ( bEnableRasterSearch && ( ((int)(cStruct.uiBestDistance) >= iRaster) || bAlwaysRasterSearch ) )
+    if ( !skipRaster && bEnableRasterSearch && ( ((int)(cStruct.uiBestDistance) >= iRaster) || bAlwaysRasterSearch ) )
     {
       cStruct.uiBestDistance = iRaster;
       for ( iStartY = sr.top; iStartY <= sr.bottom; iStartY += iRaster )
@@ -5751,6 +6316,11 @@ void InterSearch::xTZSearch(const PredictionUnit &pu, RefPicList eRefPicList, in
   // write out best match
   rcMv.set( cStruct.iBestX, cStruct.iBestY );
   ruiSAD = cStruct.uiBestSad - m_pcRdCost->getCostOfVectorWithPredictor( cStruct.iBestX, cStruct.iBestY, cStruct.imvShift );
+  if (storeMotionField)
+  {
+    s_motionFieldCache.enterCtu(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), pu.cs->pcv->maxCUWidth);
+    s_motionFieldCache.store(eRefPicList, refIdxPred, pu.Y(), cStruct.iBestX, cStruct.iBestY, ruiSAD);
+  }
 }
 
 void InterSearch::xTZSearchSelective(const PredictionUnit &pu, RefPicList eRefPicList, int refIdxPred,
@@ -6119,12 +6689,46 @@ void InterSearch::xPatternSearchFracDIF(const PredictionUnit &pu, RefPicList eRe
   //  Reference pattern initialization (integer scale)
   ptrdiff_t offset = rcMvInt.getHor() + rcMvInt.getVer() * cStruct.iRefStride;
   CPelBuf cPatternRoi(cStruct.piRefY + offset, cStruct.iRefStride, *cStruct.pcPatternKey);
+
+  // CAROL: refinamento direto nos planos fracionários da referência, sem interpolar por CU
+  const CAROL::SubPelPlanes::Planes* subPelPlanes = nullptr;
+  const Picture* refPic = pu.cu->slice->getRefPic(eRefPicList, refIdx);
+  if (m_pcEncCfg->CAROL_getSubPelPlanesMaxRefs() > 0 && !cStruct.useAltHpelIf && !refPic->isWrapAroundEnabled(pu.cs->pps)
+      && pu.cu->slice->getScalingRatio(eRefPicList, refIdx) == SCALE_1X)
+  {
+    if (m_pcEncCfg->CAROL_getSubPelPlanesThreads() > 1
+        && (!s_subPelWorkerPool || s_subPelWorkerPool->getNumThreads() != m_pcEncCfg->CAROL_getSubPelPlanesThreads()))
+    {
+      s_subPelWorkerPool.reset(new CAROL::WorkerPool(m_pcEncCfg->CAROL_getSubPelPlanesThreads()));
+    }
+    subPelPlanes = s_subPelPlanes.get(*refPic, m_lumaClpRng, m_pcEncCfg->CAROL_getSubPelPlanesMaxRefs(),
+                                      m_pcEncCfg->CAROL_getSubPelPlanesThreads() > 1 ? s_subPelWorkerPool.get() : nullptr);
+  }
+  const Position subPelPos(pu.lx() + rcMvInt.getHor(), pu.ly() + rcMvInt.getVer());
+  if (subPelPlanes
+      && !subPelPlanes->contains(subPelPos.x - 1, subPelPos.y - 1, cPatternRoi.width + 2, cPatternRoi.height + 2))
+  {
+    subPelPlanes = nullptr;
+  }
+  SubPelPlanesScope subPelPlanesScope(subPelPlanes, subPelPos);
+
+  // CAROL: modelo quadrático ajustado aos SADs inteiros em torno do melhor ponto
+  CAROL::IntCostSurface::Model fracModel;
+  const bool fracModelFitted = (m_pcEncCfg->CAROL_getPredictiveFracRefine() || m_pcEncCfg->CAROL_getSubPelFit())
+                               && s_intCostSurface.fit(intCostSurfaceOwner(pu, eRefPicList, refIdx, m_cDistParam.isBiPred),
+                                                       rcMvInt.getHor(), rcMvInt.getVer(), fracModel);
+  const bool useFracModel = fracModelFitted && m_pcEncCfg->CAROL_getPredictiveFracRefine();
+  FracRefineModelScope fracModelScope(useFracModel ? &fracModel : nullptr);
+
   if (m_skipFracME)
   {
     Mv baseRefMv(0, 0);
     rcMvHalf.setZero();
     m_pcRdCost->setCostScale(0);
-    xExtDIFUpSamplingH(&cPatternRoi, cStruct.useAltHpelIf);
+    if (!subPelPlanes)
+    {
+      xExtDIFUpSamplingH(&cPatternRoi, cStruct.useAltHpelIf);
+    }
     rcMvQter = rcMvInt;   rcMvQter <<= 2;    // for mv-cost
 #if GDR_ENABLED
     ruiCost = xPatternRefinement(pu, eRefPicList, refIdx, cStruct.pcPatternKey, baseRefMv, 1, rcMvQter,
@@ -6146,9 +6750,83 @@ void InterSearch::xPatternSearchFracDIF(const PredictionUnit &pu, RefPicList eRe
     return;
   }
 
+  // CAROL: vetor fracionário no mínimo do modelo quadrático dos SADs inteiros, confirmado contra o vetor
+  // inteiro com uma única interpolação, no lugar das passadas de meia e de um quarto de amostra
+  bool trySubPelFit = m_pcEncCfg->CAROL_getSubPelFit() && cStruct.imvShift == IMV_OFF && !cStruct.useAltHpelIf;
+#if GDR_ENABLED
+  trySubPelFit = trySubPelFit && !pu.cs->sps->getGDREnabledFlag();
+#endif
+  if (trySubPelFit)
+  {
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::SUB_PEL_FIT_SEARCHES, 1);
+  }
+  if (trySubPelFit && fracModelFitted)
+  {
+    // mínimo da parábola de cada eixo, limitado ao alcance das duas passadas (3/4) e arredondado a 1/4
+    auto quarterOffset = [](double b, double a) { return (int) std::lround(Clip3(-0.75, 0.75, -b / (2 * a)) * 4); };
+    const int  fracHor = quarterOffset(fracModel.bx, fracModel.ax);
+    const int  fracVer = quarterOffset(fracModel.by, fracModel.ay);
+    const bool useHad  = m_pcEncCfg->getUseHADME() && !pu.cs->slice->getDisableSATDForRD();
+
+    m_pcRdCost->setCostScale(0);
+    m_pcRdCost->setDistParam(m_cDistParam, *cStruct.pcPatternKey, cPatternRoi.buf, cStruct.iRefStride, m_lumaClpRng.bd,
+                             COMPONENT_Y, 0, 1, useHad);
+    ruiCost = m_cDistParam.distFunc(m_cDistParam);
+    ruiCost += m_pcRdCost->getCostOfVectorWithPredictor(rcMvInt.getHor() * 4, rcMvInt.getVer() * 4, 0);
+    rcMvHalf.setZero();
+    rcMvQter.setZero();
+
+    if (fracHor != 0 || fracVer != 0)
+    {
+      const int  intHor = fracHor >> 2;
+      const int  intVer = fracVer >> 2;
+      const Pel* predBuf;
+      ptrdiff_t  predStride;
+      if (subPelPlanes)
+      {
+        predBuf = subPelPlanes->at(fracHor & 3, fracVer & 3, subPelPos.x + intHor, subPelPos.y + intVer, predStride);
+      }
+      else
+      {
+        // mesmo filtro em dois estágios do xExtDIFUpSamplingH/Q, só na fase do vetor ajustado
+        const int  width          = cPatternRoi.width;
+        const int  height         = cPatternRoi.height;
+        const int  halfFilterSize = NTAPS_LUMA >> 1;
+        const Pel* srcPtr = cPatternRoi.buf + (intVer - (halfFilterSize - 1)) * cStruct.iRefStride + intHor;
+
+        predStride = width + 1;
+        m_if.filterHor(COMPONENT_Y, srcPtr, cStruct.iRefStride, m_filteredBlockTmp[0][0], predStride, width,
+                       height + NTAPS_LUMA - 1, (fracHor & 3) << MV_FRACTIONAL_BITS_DIFF, false, m_lumaClpRng,
+                       InterpolationFilter::Filter::DEFAULT);
+        m_if.filterVer(COMPONENT_Y, m_filteredBlockTmp[0][0] + (halfFilterSize - 1) * predStride, predStride,
+                       m_filteredBlock[0][0][0], predStride, width, height, (fracVer & 3) << MV_FRACTIONAL_BITS_DIFF,
+                       false, true, m_lumaClpRng, InterpolationFilter::Filter::DEFAULT);
+        predBuf = m_filteredBlock[0][0][0];
+      }
+
+      m_pcRdCost->setDistParam(m_cDistParam, *cStruct.pcPatternKey, predBuf, predStride, m_lumaClpRng.bd, COMPONENT_Y,
+                               0, 1, useHad);
+      Distortion fracCost = m_cDistParam.distFunc(m_cDistParam);
+      fracCost += m_pcRdCost->getCostOfVectorWithPredictor(rcMvInt.getHor() * 4 + fracHor,
+                                                           rcMvInt.getVer() * 4 + fracVer, 0);
+      if (fracCost < ruiCost)
+      {
+        // mesma decomposição do resultado das duas passadas: meia amostra + resto em 1/4
+        ruiCost = fracCost;
+        rcMvHalf.set(fracHor / 2, fracVer / 2);
+        rcMvQter.set(fracHor - 2 * (fracHor / 2), fracVer - 2 * (fracVer / 2));
+      }
+    }
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::SUB_PEL_FIT_USED, 1);
+    return;
+  }
+
   //  Half-pel refinement
   m_pcRdCost->setCostScale(1);
-  xExtDIFUpSamplingH(&cPatternRoi, cStruct.useAltHpelIf);
+  if (!subPelPlanes)
+  {
+    xExtDIFUpSamplingH(&cPatternRoi, cStruct.useAltHpelIf);
+  }
 
   rcMvHalf = rcMvInt;   rcMvHalf <<= 1;    // for mv-cost
   Mv baseRefMv(0, 0);
@@ -6163,7 +6841,10 @@ void InterSearch::xPatternSearchFracDIF(const PredictionUnit &pu, RefPicList eRe
   if (cStruct.imvShift == IMV_OFF)
   {
     m_pcRdCost->setCostScale(0);
-    xExtDIFUpSamplingQ(&cPatternRoi, rcMvHalf);
+    if (!subPelPlanes)
+    {
+      xExtDIFUpSamplingQ(&cPatternRoi, rcMvHalf);
+    }
     baseRefMv = rcMvHalf;
     baseRefMv <<= 1;
 
@@ -6185,11 +6866,27 @@ Distortion InterSearch::xGetSymmetricCost( PredictionUnit& pu, PelUnitBuf& origB
   Distortion cost = std::numeric_limits<Distortion>::max();
   RefPicList eTarRefPicList = (RefPicList)(1 - (int)eCurRefPicList);
 
+  Mv mvA = cCurMvField.mv;
+  clipMv( mvA, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+  Mv mvB = cTarMvField.mv;
+  clipMv( mvB, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+
+  // CAROL: par já avaliado nesta busca simétrica
+  const bool useSymmetricCache = s_symmetricPredCache.isActive();
+  if (useSymmetricCache)
+  {
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::SMVD_PAIRS);
+    if (s_symmetricPredCache.findCost(eCurRefPicList, mvA, mvB, cost))
+    {
+      CAROL::SpeedupStats::getInstance().add(CAROL::StatId::SMVD_PAIRS_REUSED);
+      return cost;
+    }
+  }
+
   // get prediction of eCurRefPicList
   PelUnitBuf predBufA = m_tmpPredStorage[eCurRefPicList].getBuf( UnitAreaRelative( *pu.cu, pu ) );
   const Picture* picRefA = pu.cu->slice->getRefPic( eCurRefPicList, cCurMvField.refIdx );
-  Mv mvA = cCurMvField.mv;
-  clipMv( mvA, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+  const Pel* cachedPredA = useSymmetricCache ? s_symmetricPredCache.findPred(eCurRefPicList, mvA) : nullptr;
   if ( (mvA.hor & 15) == 0 && (mvA.ver & 15) == 0 )
   {
     Position offset = pu.blocks[COMPONENT_Y].pos().offset( mvA.getHor() >> 4, mvA.getVer() >> 4 );
@@ -6199,17 +6896,25 @@ Distortion InterSearch::xGetSymmetricCost( PredictionUnit& pu, PelUnitBuf& origB
     predBufA.bufs[0].width = pelBufA.width;
     predBufA.bufs[0].height = pelBufA.height;
   }
+  else if (cachedPredA)
+  {
+    predBufA.bufs[0].buf    = const_cast<Pel *>(cachedPredA);
+    predBufA.bufs[0].stride = pu.lwidth();
+  }
   else
   {
     xPredInterBlk(COMPONENT_Y, pu, picRefA, mvA, predBufA, false, pu.cu->slice->clpRng(COMPONENT_Y), false, false,
                   eCurRefPicList);
+    if (useSymmetricCache)
+    {
+      s_symmetricPredCache.storePred(eCurRefPicList, mvA, predBufA.Y());
+    }
   }
 
   // get prediction of eTarRefPicList
   PelUnitBuf predBufB = m_tmpPredStorage[eTarRefPicList].getBuf( UnitAreaRelative( *pu.cu, pu ) );
   const Picture* picRefB = pu.cu->slice->getRefPic( eTarRefPicList, cTarMvField.refIdx );
-  Mv mvB = cTarMvField.mv;
-  clipMv( mvB, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+  const Pel* cachedPredB = useSymmetricCache ? s_symmetricPredCache.findPred(eTarRefPicList, mvB) : nullptr;
   if ( (mvB.hor & 15) == 0 && (mvB.ver & 15) == 0 )
   {
     Position offset = pu.blocks[COMPONENT_Y].pos().offset( mvB.getHor() >> 4, mvB.getVer() >> 4 );
@@ -6217,10 +6922,19 @@ Distortion InterSearch::xGetSymmetricCost( PredictionUnit& pu, PelUnitBuf& origB
     predBufB.bufs[0].buf = const_cast<Pel *>(pelBufB.buf);
     predBufB.bufs[0].stride = pelBufB.stride;
   }
+  else if (cachedPredB)
+  {
+    predBufB.bufs[0].buf    = const_cast<Pel *>(cachedPredB);
+    predBufB.bufs[0].stride = pu.lwidth();
+  }
   else
   {
     xPredInterBlk(COMPONENT_Y, pu, picRefB, mvB, predBufB, false, pu.cu->slice->clpRng(COMPONENT_Y), false, false,
                   eTarRefPicList);
+    if (useSymmetricCache)
+    {
+      s_symmetricPredCache.storePred(eTarRefPicList, mvB, predBufB.Y());
+    }
   }
 
   PelUnitBuf bufTmp = m_tmpStorageCtu.getBuf(UnitAreaRelative(*pu.cu, pu));
@@ -6235,6 +6949,10 @@ Distortion InterSearch::xGetSymmetricCost( PredictionUnit& pu, PelUnitBuf& origB
     (Distortion) floor(fWeight
                        * (double) m_pcRdCost->getDistPart(
                          bufTmp.Y(), predBufB.Y(), pu.cs->sps->getBitDepth(ChannelType::LUMA), COMPONENT_Y, distFunc));
+  if (useSymmetricCache)
+  {
+    s_symmetricPredCache.storeCost(eCurRefPicList, mvA, mvB, cost);
+  }
   return(cost);
 }
 
@@ -6666,19 +7384,23 @@ void InterSearch::xPredAffineInterSearch(PredictionUnit &pu, PelUnitBuf &origBuf
 #endif
       }
       PelUnitBuf predBuf = m_tmpStorageCtu.getBuf(UnitAreaRelative(*pu.cu, pu));
+      // CAROL: referência sem ME translacional (término antecipado): o preditor não é ponto de partida
+      const bool hevcSeed = s_refMeSearched[refList][refIdxTemp];
 #if GDR_ENABLED
-      bool uiCandCostOk = true;
-      Distortion uiCandCost   = xGetAffineTemplateCost(pu, origBuf, predBuf, mvHevc, aaiMvpIdx[refList][refIdxTemp],
-                                                       AMVP_MAX_NUM_CANDS, eRefPicList, refIdxTemp, uiCandCostOk);
+      bool uiCandCostOk = hevcSeed;
+      Distortion uiCandCost   = hevcSeed ? xGetAffineTemplateCost(pu, origBuf, predBuf, mvHevc, aaiMvpIdx[refList][refIdxTemp],
+                                                                  AMVP_MAX_NUM_CANDS, eRefPicList, refIdxTemp, uiCandCostOk)
+                                         : std::numeric_limits<Distortion>::max();
 
       uiCandCostOk = uiCandCostOk && mvHevcSolid[0] && mvHevcSolid[1] && ((mvNum > 2) ? mvHevcSolid[2] : true);
 
 #else
-      Distortion uiCandCost = xGetAffineTemplateCost(pu, origBuf, predBuf, mvHevc, aaiMvpIdx[refList][refIdxTemp],
-                                                     AMVP_MAX_NUM_CANDS, eRefPicList, refIdxTemp);
+      Distortion uiCandCost = hevcSeed ? xGetAffineTemplateCost(pu, origBuf, predBuf, mvHevc, aaiMvpIdx[refList][refIdxTemp],
+                                                                AMVP_MAX_NUM_CANDS, eRefPicList, refIdxTemp)
+                                       : std::numeric_limits<Distortion>::max();
 #endif
 
-      if ( affineAmvrEnabled )
+      if ( affineAmvrEnabled && hevcSeed )
       {
         uiCandCost += m_pcRdCost->getCost(xCalcAffineMVBits(pu, mvHevc, cMvPred[refList][refIdxTemp]));
       }
@@ -6757,7 +7479,6 @@ void InterSearch::xPredAffineInterSearch(PredictionUnit &pu, PelUnitBuf &origBuf
       if (pu.cu->affineType == AffineModel::_4_PARAMS && m_affMVListSize
           && (!pu.cu->cs->sps->getUseBcw() || bcwIdx == BCW_DEFAULT))
       {
-        int shift = MAX_CU_DEPTH;
         for (int i = 0; i < m_affMVListSize; i++)
         {
           AffineMVInfo *mvInfo = m_affMVList + ((m_affMVListIdx - i - 1 + m_affMVListMaxSize) % (m_affMVListMaxSize));
@@ -6789,34 +7510,7 @@ void InterSearch::xPredAffineInterSearch(PredictionUnit &pu, PelUnitBuf &origBuf
           mvTmpSolid[0] = nbMvSolid[0];
           mvTmpSolid[1] = nbMvSolid[1];
 #endif
-          int vx, vy;
-          int dMvHorX, dMvHorY, dMvVerX, dMvVerY;
-          int mvScaleHor = nbMv[0].getHor() * (1 << shift);
-          int mvScaleVer = nbMv[0].getVer() * (1 << shift);
-          Mv dMv = nbMv[1] - nbMv[0];
-
-          dMvHorX = dMv.getHor() * (1 << (shift - floorLog2(mvInfo->w)));
-          dMvHorY = dMv.getVer() * (1 << (shift - floorLog2(mvInfo->w)));
-          dMvVerX = -dMvHorY;
-          dMvVerY = dMvHorX;
-
-          vx = mvScaleHor + dMvHorX * (pu.Y().x - mvInfo->x) + dMvVerX * (pu.Y().y - mvInfo->y);
-          vy = mvScaleVer + dMvHorY * (pu.Y().x - mvInfo->x) + dMvVerY * (pu.Y().y - mvInfo->y);
-
-          mvTmp[0] = Mv(vx, vy);
-          mvTmp[0] >>= shift;
-          mvTmp[0].clipToStorageBitDepth();
-          clipMv( mvTmp[0], pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
-          mvTmp[0].roundAffinePrecInternal2Amvr(pu.cu->imv);
-
-          vx = mvScaleHor + dMvHorX * (pu.Y().x + pu.Y().width - mvInfo->x) + dMvVerX * (pu.Y().y - mvInfo->y);
-          vy = mvScaleVer + dMvHorY * (pu.Y().x + pu.Y().width - mvInfo->x) + dMvVerY * (pu.Y().y - mvInfo->y);
-
-          mvTmp[1] = Mv(vx, vy);
-          mvTmp[1] >>= shift;
-          mvTmp[1].clipToStorageBitDepth();
-          clipMv(mvTmp[1], pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps);
-          mvTmp[1].roundAffinePrecInternal2Amvr(pu.cu->imv);
+          inheritAffineModel(pu, mvInfo->x, mvInfo->y, mvInfo->w, nbMv, mvTmp);
 
 #if GDR_ENABLED
           bool tmpCostOk = true;
@@ -6864,6 +7558,48 @@ void InterSearch::xPredAffineInterSearch(PredictionUnit &pu, PelUnitBuf &origBuf
           }
         }
       }
+
+      // CAROL: modelos convergidos dos blocos da CTU que sobrepõem ou contêm o CU, por consulta direta à grade
+      bool mvHevcFromIndex = false;
+      if (m_pcEncCfg->CAROL_getAffineModelIndex() && pu.cu->affineType == AffineModel::_4_PARAMS
+          && (!pu.cu->cs->sps->getUseBcw() || bcwIdx == BCW_DEFAULT)
+#if GDR_ENABLED
+          && !isEncodeGdrClean
+#endif
+         )
+      {
+        s_affineModelIndex.enterCtu(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), pu.cs->pcv->maxCUWidth);
+        CAROL::AffineModelIndex::Model models[CAROL::AffineModelIndex::MAX_MODELS];
+        const int numModels = s_affineModelIndex.lookup(refList, refIdxTemp, pu.Y(), models);
+        if (numModels > 0)
+        {
+          CAROL::SpeedupStats::getInstance().add(CAROL::StatId::AFFINE_INDEX_LOOKUPS);
+        }
+        for (int i = 0; i < numModels; i++)
+        {
+          Mv mvTmp[3];
+          inheritAffineModel(pu, models[i].x, models[i].y, models[i].w, models[i].mv, mvTmp);
+#if GDR_ENABLED
+          bool tmpCostOk = true;
+          Distortion tmpCost   = xGetAffineTemplateCost(pu, origBuf, predBuf, mvTmp, aaiMvpIdx[refList][refIdxTemp],
+                                                        AMVP_MAX_NUM_CANDS, eRefPicList, refIdxTemp, tmpCostOk);
+#else
+          Distortion tmpCost = xGetAffineTemplateCost(pu, origBuf, predBuf, mvTmp, aaiMvpIdx[refList][refIdxTemp],
+                                                      AMVP_MAX_NUM_CANDS, eRefPicList, refIdxTemp);
+#endif
+          if ( affineAmvrEnabled )
+          {
+            tmpCost += m_pcRdCost->getCost(xCalcAffineMVBits(pu, mvTmp, cMvPred[refList][refIdxTemp]));
+          }
+          if (tmpCost < uiCandCost)
+          {
+            uiCandCost = tmpCost;
+            std::memcpy(mvHevc, mvTmp, 3 * sizeof(Mv));
+            mvHevcFromIndex = true;
+          }
+        }
+      }
+
       if (pu.cu->affineType == AffineModel::_6_PARAMS)
       {
         Mv mvFour[3];
@@ -6993,6 +7729,12 @@ void InterSearch::xPredAffineInterSearch(PredictionUnit &pu, PelUnitBuf &origBuf
 #endif
       }
 
+      // CAROL: o modelo herdado do índice já explica o bloco abaixo do limiar de SATD por amostra: a busca
+      // afim desta referência só avalia o ponto inicial
+      AffineSkipIterationsScope skipIterationsScope(
+        mvHevcFromIndex && uiCandCost < biPDistTemp
+        && uiCandCost < m_pcEncCfg->CAROL_getAffineModelSatdTh() * pu.Y().area());
+
       // GPB list 1, save the best MvpIdx, RefIdx and Cost
 #if GDR_ENABLED
       allOk = (slice.getPicHeader()->getMvdL1ZeroFlag() && refList == 1 && (biPDistTemp < bestBiPDist));
@@ -7368,6 +8110,20 @@ void InterSearch::xPredAffineInterSearch(PredictionUnit &pu, PelUnitBuf &origBuf
         m_affMVListSize = std::min(m_affMVListSize + 1, m_affMVListMaxSize);
         m_affMVListIdx = (m_affMVListIdx + 1) % (m_affMVListMaxSize);
       }
+
+      // CAROL: os mesmos modelos vão para a grade da CTU, consultada pelos CUs seguintes de qualquer tamanho
+      if (m_pcEncCfg->CAROL_getAffineModelIndex())
+      {
+        s_affineModelIndex.enterCtu(CAROL::CtuTag::of(*pu.cs, pu.lumaPos()), pu.cs->pcv->maxCUWidth);
+        for (int refList = 0; refList < iNumPredDir; refList++)
+        {
+          const RefPicList eRefPicList = refList ? REF_PIC_LIST_1 : REF_PIC_LIST_0;
+          for (int refIdxTemp = 0; refIdxTemp < slice.getNumRefIdx(eRefPicList); refIdxTemp++)
+          {
+            s_affineModelIndex.store(refList, refIdxTemp, pu.Y(), cMvTemp[refList][refIdxTemp]);
+          }
+        }
+      }
     }
   }
 
@@ -8366,6 +9122,7 @@ void InterSearch::xAffineMotionEstimation(PredictionUnit &pu, PelUnitBuf &origBu
                                           Distortion &ruiCost, int &mvpIdx, const AffineAMVPInfo &aamvpi, bool bBi)
 #endif
 {
+  CAROL_SCOPED_TIMER(AFFINE_MOTION_ESTIMATION);
 #if GDR_ENABLED
   if (pu.cu->cs->sps->getUseBcw() && pu.cu->bcwIdx != BCW_DEFAULT && !bBi
       && xReadBufferedAffineUniMv(pu, eRefPicList, refIdxPred, acMvPred, acMv, acMvSolid, ruiBits, ruiCost, mvpIdx,
@@ -8535,46 +9292,65 @@ void InterSearch::xAffineMotionEstimation(PredictionUnit &pu, PelUnitBuf &origBu
   {
     iIterTime = bBi ? 5 : 7;
   }
+  // CAROL: ponto inicial herdado do índice de modelos da CTU já abaixo do limiar de SATD
+  if (s_affineSkipIterations)
+  {
+    CAROL::SpeedupStats::getInstance().add(CAROL::StatId::AFFINE_INDEX_SKIPPED);
+    iIterTime = 0;
+  }
   for ( int iter=0; iter<iIterTime; iter++ )    // iterate loop
   {
     memcpy( prevIterMv[iter], acMvTemp, sizeof( Mv ) * 3 );
     /*********************************************************************************
      *                         use gradient to update mv
      *********************************************************************************/
-    // get Error Matrix
-    Pel* pOrg  = pBuf->Y().buf;
-    Pel* pPred = predBuf.Y().buf;
-    for ( int j=0; j< height; j++ )
+    for ( int row = 0; row < iParaNum; row++ )
     {
-      for ( int i=0; i< width; i++ )
-      {
-        piError[i + j * width] = pOrg[i] - pPred[i];
-      }
-      pOrg  += bufStride;
-      pPred += predBufStride;
+      memset( &i64EqualCoeff[row][0], 0, iParaNum * sizeof( int64_t ) );
     }
 
-    // sobel x direction
-    // -1 0 1
-    // -2 0 2
-    // -1 0 1
-    pPred = predBuf.Y().buf;
-    m_HorizontalSobelFilter( pPred, predBufStride, pdDerivate[0], width, width, height );
-
-    // sobel y direction
-    // -1 -2 -1
-    //  0  0  0
-    //  1  2  1
-    m_VerticalSobelFilter( pPred, predBufStride, pdDerivate[1], width, width, height );
+    // CAROL: primeira iteração só com as linhas pares nos blocos grandes
+    const int rowStep = (iter == 0 && m_pcEncCfg->CAROL_getAffineHalfRowsMinArea() > 0
+                         && width * height >= m_pcEncCfg->CAROL_getAffineHalfRowsMinArea()) ? 2 : 1;
 
-    // solve delta x and y
-    for ( int row = 0; row < iParaNum; row++ )
+    if (m_pcEncCfg->CAROL_getAffineFusedGradient() || rowStep > 1)
     {
-      memset( &i64EqualCoeff[row][0], 0, iParaNum * sizeof( int64_t ) );
+      // CAROL: resíduo, Sobel e equações normais numa única passada
+      CAROL::accumulateAffineNormalEquation(pBuf->Y().buf, bufStride, predBuf.Y().buf, predBufStride, width, height,
+                                            rowStep, pu.cu->affineType == AffineModel::_6_PARAMS, i64EqualCoeff);
     }
+    else
+    {
+      // get Error Matrix
+      Pel* pOrg  = pBuf->Y().buf;
+      Pel* pPred = predBuf.Y().buf;
+      for ( int j=0; j< height; j++ )
+      {
+        for ( int i=0; i< width; i++ )
+        {
+          piError[i + j * width] = pOrg[i] - pPred[i];
+        }
+        pOrg  += bufStride;
+        pPred += predBufStride;
+      }
+
+      // sobel x direction
+      // -1 0 1
+      // -2 0 2
+      // -1 0 1
+      pPred = predBuf.Y().buf;
+      m_HorizontalSobelFilter( pPred, predBufStride, pdDerivate[0], width, width, height );
 
-    m_EqualCoeffComputer(piError, width, pdDerivate, width, i64EqualCoeff, width, height,
-                         (pu.cu->affineType == AffineModel::_6_PARAMS));
+      // sobel y direction
+      // -1 -2 -1
+      //  0  0  0
+      //  1  2  1
+      m_VerticalSobelFilter( pPred, predBufStride, pdDerivate[1], width, width, height );
+
+      // solve delta x and y
+      m_EqualCoeffComputer(piError, width, pdDerivate, width, i64EqualCoeff, width, height,
+                           (pu.cu->affineType == AffineModel::_6_PARAMS));
+    }
 
     for ( int row = 0; row < iParaNum; row++ )
     {
@@ -8613,6 +9389,22 @@ void InterSearch::xAffineMotionEstimation(PredictionUnit &pu, PelUnitBuf &origBu
 
     const double amvrScale = Mv::getAffineAmvrScale(pu.cu->imv);
 
+    // CAROL: convergência quando a maior atualização dos vetores de controle (na precisão AMVR) é pequena
+    if (m_pcEncCfg->CAROL_getAffineConvergenceTh() > 0)
+    {
+      CAROL::SpeedupStats::getInstance().add(CAROL::StatId::AFFINE_GN_ITERATIONS);
+      double maxDelta = 0;
+      for (int i = 0; i < affineParaNum; i++)
+      {
+        maxDelta = std::max(maxDelta, std::abs(dDeltaMv[i]) * amvrScale);
+      }
+      if (maxDelta < m_pcEncCfg->CAROL_getAffineConvergenceTh())
+      {
+        CAROL::SpeedupStats::getInstance().add(CAROL::StatId::AFFINE_GN_CONVERGED);
+        break;
+      }
+    }
+
     acDeltaMv[0] = Mv((int) (dDeltaMv[0] * amvrScale + sgn2(dDeltaMv[0]) * 0.5),
                       (int) (dDeltaMv[2] * amvrScale + sgn2(dDeltaMv[2]) * 0.5));
     acDeltaMv[1] = Mv((int) (dDeltaMv[1] * amvrScale + sgn2(dDeltaMv[1]) * 0.5),
@@ -9525,6 +10317,25 @@ void InterSearch::calcMinDistSbt( CodingStructure &cs, const CodingUnit& cu, con
     uint32_t          shift = DISTORTION_PRECISION_ADJUSTMENT((*cs.sps.getBitDepth(toChannelType(compID)) - 8) << 1);
     Intermediate_Int  temp;
 
+    // CAROL: SSE do CU numa passada para as somas de prefixo; cada sub-parte é uma consulta
+    if (m_pcEncCfg->CAROL_getSbtPrefixSumDist())
+    {
+      s_sbtDistMap.build(compID, orgPel, predPel, shift);
+      for (int j = 0; j < numPartY; j++)
+      {
+        for (int i = 0; i < numPartX; i++)
+        {
+          Distortion sum = s_sbtDistMap.rect(compID, i * lengthX, j * lengthY, lengthX, lengthY);
+          if (isChroma(compID))
+          {
+            sum = (Distortion) (sum * m_pcRdCost->getChromaWeight());
+          }
+          dist[j][i] += sum;
+        }
+      }
+      continue;
+    }
+
     //calc distY of 16 sub parts
     for( int j = 0; j < numPartY; j++ )
     {
@@ -9738,6 +10549,7 @@ void InterSearch::xEstimateInterResidualQT(CodingStructure &cs, Partitioner &par
                                            ,
                                            const bool luma, const bool chroma, PelUnitBuf *orgResi)
 {
+  CAROL_SCOPED_TIMER(ESTIMATE_INTER_RESIDUAL_QT);
   const UnitArea& currArea = partitioner.currArea();
   const SPS &sps           = *cs.sps;
   m_pcRdCost->setChromaFormat(sps.getChromaFormatIdc());
@@ -9745,6 +10557,7 @@ void InterSearch::xEstimateInterResidualQT(CodingStructure &cs, Partitioner &par
   const uint32_t numValidComp  = getNumberValidComponents( sps.getChromaFormatIdc() );
   const uint32_t numTBlocks    = getNumberValidTBlocks   ( *cs.pcv );
   const CodingUnit &cu = *cs.getCU(partitioner.chType);
+  CAROL_BLOCK_TIMER(INTER_RESIDUAL_QT, cu, partitioner.currTrDepth == 0);
 
 
  // const int frame = (int) cs.picture->getPOC();
@@ -9962,6 +10775,21 @@ void InterSearch::xEstimateInterResidualQT(CodingStructure &cs, Partitioner &par
       }
 
       const int numTransformCandidates = nNumTransformCands;
+      // CAROL: busca o vencedor MTS de um resíduo idêntico (ou quase) nesta mesma área
+      const bool useMtsCache = m_pcEncCfg->CAROL_getMtsCache() && compID == COMPONENT_Y && mtsAllowed
+                               && numTransformCandidates > 1;
+      uint64_t   mtsCacheKey  = 0;
+      int        bestTrMode   = 0;
+      const CAROL::MtsDecisionCache::Entry *mtsCacheEntry = nullptr;
+      if (useMtsCache)
+      {
+        s_mtsDecisionCache.enterCtu(CAROL::CtuTag::of(cs, cu.lumaPos()));
+        const CPelBuf resi = colorTransFlag ? CPelBuf(colorTransResidual.bufs[compID]) : cs.getOrgResiBuf(compArea);
+        mtsCacheKey   = CAROL::MtsDecisionCache::makeKey(compArea, cu.qp, colorTransFlag,
+                                                         CAROL::MtsDecisionCache::hashResidual(resi, m_pcEncCfg->CAROL_getMtsCacheResiShift()));
+        mtsCacheEntry = s_mtsDecisionCache.find(mtsCacheKey);
+        CAROL::SpeedupStats::getInstance().add(CAROL::StatId::MTS_CACHE_LOOKUPS);
+      }
       for( int transformMode = 0; transformMode < numTransformCandidates; transformMode++ )
       {
         const bool isFirstMode = transformMode == 0;
@@ -9988,6 +10816,27 @@ void InterSearch::xEstimateInterResidualQT(CodingStructure &cs, Partitioner &par
           {
             continue;
           }
+          // CAROL: descarta o candidato MTS cujo limite inferior de custo já supera o melhor custo
+          if (m_pcEncCfg->CAROL_getMtsEarlyTerm() && compID == COMPONENT_Y && !isFirstMode
+              && trModes[transformMode].first >= MtsType::DST7_DST7 && minCost[compID] < MAX_DOUBLE
+              && !m_pcEncCfg->getLumaLevelToDeltaQPMapping().isEnabled())
+          {
+            auto &stats = CAROL::SpeedupStats::getInstance();
+            stats.add(CAROL::StatId::MTS_ET_CHECKED);
+            CAROL::MtsBoundParams boundParams;
+            boundParams.bitDepth              = channelBitDepth;
+            boundParams.maxLog2TrDynamicRange = sps.getMaxLog2TrDynamicRange(toChannelType(compID));
+            boundParams.distShift             = DISTORTION_PRECISION_ADJUSTMENT((channelBitDepth - 8) << 1);
+            boundParams.costPerDist           = m_pcRdCost->calcRdCost(0, 1);
+            boundParams.costPerBit            = m_pcRdCost->calcRdCost(1 << SCALE_BITS, 0);
+            boundParams.signHiding            = slice.getSignDataHidingEnabledFlag();
+            if (CAROL::mtsCostLowerBound(csFull->getResiBuf(compArea), trModes[transformMode].first, boundParams)
+                > minCost[compID])
+            {
+              stats.add(CAROL::StatId::MTS_ET_SKIPPED);
+              continue;
+            }
+          }
         }
         tu.mtsIdx[compID] = trModes[transformMode].first;
         QpParam cQP(tu, compID);   // note: uses tu.transformSkip[compID]
@@ -10026,6 +10875,27 @@ void InterSearch::xEstimateInterResidualQT(CodingStructure &cs, Partitioner &par
           {
             m_pcTrQuant->transformNxN(tu, compID, cQP, trModes, m_pcEncCfg->getMTSInterMaxCand());
             tu.mtsIdx[compID] = trModes[0].first;
+            if (mtsCacheEntry != nullptr)
+            {
+              // mantém apenas o primeiro candidato (referência de resíduo zero) e o vencedor do cache
+              int cachedMode = mtsCacheEntry->rank;
+              if (cachedMode >= numTransformCandidates || trModes[cachedMode].first != mtsCacheEntry->mtsIdx)
+              {
+                cachedMode = -1;
+                for (int i = 0; i < numTransformCandidates; i++)
+                {
+                  cachedMode = trModes[i].first == mtsCacheEntry->mtsIdx ? i : cachedMode;
+                }
+              }
+              if (cachedMode >= 0)
+              {
+                for (int i = 1; i < numTransformCandidates; i++)
+                {
+                  trModes[i].second = i == cachedMode;
+                }
+                CAROL::SpeedupStats::getInstance().add(CAROL::StatId::MTS_CACHE_HITS);
+              }
+            }
           }
           if (!(m_pcEncCfg->getCostMode() == COST_LOSSLESS_CODING && slice.isLossless()
                 && tu.mtsIdx[compID] == MtsType::DCT2_DCT2))
@@ -10163,6 +11033,7 @@ void InterSearch::xEstimateInterResidualQT(CodingStructure &cs, Partitioner &par
           uiSingleDistComp[compID] = currCompDist;
           uiSingleFracBits[compID] = currCompFracBits;
           minCost[compID]          = currCompCost;
+          bestTrMode               = transformMode;
 
           bestTU.copyComponentFrom(tu, compID);
           saveCS.getResiBuf(compArea).copyFrom(csFull->getResiBuf(compArea));
@@ -10176,6 +11047,10 @@ void InterSearch::xEstimateInterResidualQT(CodingStructure &cs, Partitioner &par
       // copy component
       tu.copyComponentFrom(bestTU, compID);
       csFull->getResiBuf(compArea).copyFrom(saveCS.getResiBuf(compArea));
+      if (useMtsCache && mtsCacheEntry == nullptr && tu.cbf[compID])
+      {
+        s_mtsDecisionCache.store(mtsCacheKey, tu.mtsIdx[compID], bestTrMode);
+      }
       if (colorTransFlag && (m_pcEncCfg->getCostMode() != COST_LOSSLESS_CODING || !slice.isLossless()))
       {
         m_pcTrQuant->lambdaAdjustColorTrans(false);
@@ -11361,6 +12236,8 @@ void InterSearch::symmvdCheckBestMvp(PredictionUnit &pu, PelUnitBuf &origBuf, Mv
   const Picture* picRefA = pu.cu->slice->getRefPic(curRefList, cCurMvField.refIdx);
   Mv mvA = cCurMvField.mv;
   clipMv( mvA, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
+  const bool useSymmetricCache = s_symmetricPredCache.isActive();
+  const Pel* cachedPredA = useSymmetricCache ? s_symmetricPredCache.findPred(curRefList, mvA) : nullptr;
   if ( (mvA.hor & 15) == 0 && (mvA.ver & 15) == 0 )
   {
     Position offset = pu.blocks[COMPONENT_Y].pos().offset( mvA.getHor() >> 4, mvA.getVer() >> 4 );
@@ -11368,10 +12245,19 @@ void InterSearch::symmvdCheckBestMvp(PredictionUnit &pu, PelUnitBuf &origBuf, Mv
     predBufA.bufs[0].buf = const_cast<Pel *>(pelBufA.buf);
     predBufA.bufs[0].stride = pelBufA.stride;
   }
+  else if (cachedPredA)
+  {
+    predBufA.bufs[0].buf    = const_cast<Pel *>(cachedPredA);
+    predBufA.bufs[0].stride = pu.lwidth();
+  }
   else
   {
     xPredInterBlk(COMPONENT_Y, pu, picRefA, mvA, predBufA, false, pu.cu->slice->clpRng(COMPONENT_Y), false, false,
                   curRefList);
+    if (useSymmetricCache)
+    {
+      s_symmetricPredCache.storePred(curRefList, mvA, predBufA.Y());
+    }
   }
   PelUnitBuf bufTmp = m_tmpStorageCtu.getBuf(UnitAreaRelative(*pu.cu, pu));
   bufTmp.copyFrom( origBuf );
@@ -11400,24 +12286,51 @@ void InterSearch::symmvdCheckBestMvp(PredictionUnit &pu, PelUnitBuf &origBuf, Mv
       const Picture* picRefB = pu.cu->slice->getRefPic(tarRefList, cTarMvField.refIdx);
       Mv mvB = cTarMvField.mv;
       clipMv( mvB, pu.cu->lumaPos(), pu.cu->lumaSize(), *pu.cs->sps, *pu.cs->pps );
-      if ( (mvB.hor & 15) == 0 && (mvB.ver & 15) == 0 )
+      Distortion cost = 0;
+      // CAROL: par já avaliado na busca simétrica (mesma distorção do xGetSymmetricCost)
+      if (useSymmetricCache)
       {
-        Position offset = pu.blocks[COMPONENT_Y].pos().offset( mvB.getHor() >> 4, mvB.getVer() >> 4 );
-        CPelBuf pelBufB = picRefB->getRecoBuf( CompArea( COMPONENT_Y, pu.chromaFormat, offset, pu.blocks[COMPONENT_Y].size() ), false );
-        predBufB.bufs[0].buf = const_cast<Pel *>(pelBufB.buf);
-        predBufB.bufs[0].stride = pelBufB.stride;
+        CAROL::SpeedupStats::getInstance().add(CAROL::StatId::SMVD_PAIRS);
+      }
+      if (useSymmetricCache && s_symmetricPredCache.findCost(curRefList, mvA, mvB, cost))
+      {
+        CAROL::SpeedupStats::getInstance().add(CAROL::StatId::SMVD_PAIRS_REUSED);
       }
       else
       {
-        xPredInterBlk(COMPONENT_Y, pu, picRefB, mvB, predBufB, false, pu.cu->slice->clpRng(COMPONENT_Y), false, false,
-                      tarRefList);
+        const Pel* cachedPredB = useSymmetricCache ? s_symmetricPredCache.findPred(tarRefList, mvB) : nullptr;
+        if ( (mvB.hor & 15) == 0 && (mvB.ver & 15) == 0 )
+        {
+          Position offset = pu.blocks[COMPONENT_Y].pos().offset( mvB.getHor() >> 4, mvB.getVer() >> 4 );
+          CPelBuf pelBufB = picRefB->getRecoBuf( CompArea( COMPONENT_Y, pu.chromaFormat, offset, pu.blocks[COMPONENT_Y].size() ), false );
+          predBufB.bufs[0].buf = const_cast<Pel *>(pelBufB.buf);
+          predBufB.bufs[0].stride = pelBufB.stride;
+        }
+        else if (cachedPredB)
+        {
+          predBufB.bufs[0].buf    = const_cast<Pel *>(cachedPredB);
+          predBufB.bufs[0].stride = pu.lwidth();
+        }
+        else
+        {
+          xPredInterBlk(COMPONENT_Y, pu, picRefB, mvB, predBufB, false, pu.cu->slice->clpRng(COMPONENT_Y), false, false,
+                        tarRefList);
+          if (useSymmetricCache)
+          {
+            s_symmetricPredCache.storePred(tarRefList, mvB, predBufB.Y());
+          }
+        }
+        // calc distortion
+        const DFunc distFunc = (!pu.cu->slice->getDisableSATDForRD()) ? DFunc::HAD : DFunc::SAD;
+        cost = (Distortion) floor(
+              fWeight
+              * (double) m_pcRdCost->getDistPart(bufTmp.Y(), predBufB.Y(), pu.cs->sps->getBitDepth(ChannelType::LUMA),
+                                                 COMPONENT_Y, distFunc));
+        if (useSymmetricCache)
+        {
+          s_symmetricPredCache.storeCost(curRefList, mvA, mvB, cost);
+        }
       }
-      // calc distortion
-      const DFunc distFunc = (!pu.cu->slice->getDisableSATDForRD()) ? DFunc::HAD : DFunc::SAD;
-      Distortion cost     = (Distortion) floor(
-            fWeight
-            * (double) m_pcRdCost->getDistPart(bufTmp.Y(), predBufB.Y(), pu.cs->sps->getBitDepth(ChannelType::LUMA),
-                                               COMPONENT_Y, distFunc));
 
       Mv pred = amvpCur.mvCand[i];
       pred.changeTransPrecInternal2Amvr(pu.cu->imv);
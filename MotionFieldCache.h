@@ -0,0 +1,123 @@
+#ifndef __MOTION_FIELD_CACHE_H__
+#define __MOTION_FIELD_CACHE_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CommonLib/Mv.h"
+#include "CtuScope.h"
+#include <algorithm>
+#include <vector>
+
+namespace CAROL {
+
+// Campo de movimento da CTU em grade 8x8, por (lista, refIdx): guarda o melhor vetor inteiro e o SAD
+// por amostra já encontrados por qualquer ME que cobriu a célula. Novas buscas (128x128, 64x64, BT, TT...)
+// sobre a mesma região usam esses vetores como pontos de partida.
+class MotionFieldCache {
+public:
+    static const int GRID_LOG2 = 3;
+    static const int MAX_SEEDS = 4;
+
+    struct Cell {
+        int      hor = 0;
+        int      ver = 0;
+        uint32_t sadPerSample = MAX_UINT;   // SAD/amostra em ponto fixo (<< SAD_FRAC_BITS); MAX_UINT: vazia
+        int      area = 0;                  // área do bloco cuja busca produziu o vetor
+    };
+    static const int SAD_FRAC_BITS = 4;
+
+    // Limpa o campo ao mudar de CTU
+    void enterCtu(const CtuTag& tag, int ctuSize) {
+        if (tag != m_ctu || ctuSize != m_ctuSize) {
+            m_ctu      = tag;
+            m_ctuSize  = ctuSize;
+            m_gridSize = ctuSize >> GRID_LOG2;
+            m_cells.assign((size_t)NUM_REF_PIC_LIST_01 * MAX_NUM_REF * m_gridSize * m_gridSize, Cell());
+        }
+    }
+
+    // Vetores distintos das células cobertas pelo bloco, do menor para o maior SAD/amostra
+    int getSeeds(int list, int refIdx, const Area& blk, Cell seeds[MAX_SEEDS]) const {
+        int numSeeds = 0;
+        forEachCell(list, refIdx, blk, [&](const Cell& cell) {
+            if (cell.sadPerSample == MAX_UINT) return;
+            for (int i = 0; i < numSeeds; i++) {
+                if (seeds[i].hor == cell.hor && seeds[i].ver == cell.ver) {
+                    seeds[i].sadPerSample = std::min(seeds[i].sadPerSample, cell.sadPerSample);
+                    return;
+                }
+            }
+            if (numSeeds < MAX_SEEDS) {
+                seeds[numSeeds++] = cell;
+            } else if (cell.sadPerSample < seeds[MAX_SEEDS - 1].sadPerSample) {
+                seeds[MAX_SEEDS - 1] = cell;
+            } else {
+                return;
+            }
+            std::sort(seeds, seeds + numSeeds, [](const Cell& a, const Cell& b) { return a.sadPerSample < b.sadPerSample; });
+        });
+        return numSeeds;
+    }
+
+    // Vetor de menor SAD/amostra nas células do bloco vindo de buscas em blocos com área < maxArea
+    bool getBestFromSmaller(int list, int refIdx, const Area& blk, int maxArea, Cell& best) const {
+        best = Cell();
+        forEachCell(list, refIdx, blk, [&](const Cell& cell) {
+            if (cell.area < maxArea && cell.sadPerSample < best.sadPerSample) {
+                best = cell;
+            }
+        });
+        return best.sadPerSample != MAX_UINT;
+    }
+
+    // Registra o resultado de uma busca inteira nas células cobertas, se melhor que o armazenado
+    void store(int list, int refIdx, const Area& blk, int hor, int ver, Distortion sad) {
+        const uint32_t sadPerSample = toSadPerSample(sad, blk);
+        forEachCell(list, refIdx, blk, [&](Cell& cell) {
+            if (sadPerSample < cell.sadPerSample) {
+                cell.hor = hor;
+                cell.ver = ver;
+                cell.sadPerSample = sadPerSample;
+                cell.area = blk.area();
+            }
+        });
+    }
+
+    static uint32_t toSadPerSample(Distortion sad, const Area& blk) {
+        return (uint32_t)std::min<Distortion>(MAX_UINT - 1, (sad << SAD_FRAC_BITS) / blk.area());
+    }
+
+private:
+    template<typename CellT, typename Func>
+    static void xForEachCell(CellT* cells, int gridSize, int ctuX0, int ctuY0, const Area& blk, Func func) {
+        const int x0 = std::max(0, (blk.x - ctuX0) >> GRID_LOG2);
+        const int y0 = std::max(0, (blk.y - ctuY0) >> GRID_LOG2);
+        const int x1 = std::min(gridSize, (int)((blk.x + blk.width - ctuX0 + 7) >> GRID_LOG2));
+        const int y1 = std::min(gridSize, (int)((blk.y + blk.height - ctuY0 + 7) >> GRID_LOG2));
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                func(cells[y * gridSize + x]);
+            }
+        }
+    }
+
+    template<typename Func>
+    void forEachCell(int list, int refIdx, const Area& blk, Func func) const {
+        xForEachCell(xCells(list, refIdx), m_gridSize, m_ctu.ctuX * m_ctuSize, m_ctu.ctuY * m_ctuSize, blk, func);
+    }
+    template<typename Func>
+    void forEachCell(int list, int refIdx, const Area& blk, Func func) {
+        xForEachCell(xCells(list, refIdx), m_gridSize, m_ctu.ctuX * m_ctuSize, m_ctu.ctuY * m_ctuSize, blk, func);
+    }
+
+    const Cell* xCells(int list, int refIdx) const { return m_cells.data() + (size_t)(list * MAX_NUM_REF + refIdx) * m_gridSize * m_gridSize; }
+    Cell*       xCells(int list, int refIdx)       { return m_cells.data() + (size_t)(list * MAX_NUM_REF + refIdx) * m_gridSize * m_gridSize; }
+
+    CtuTag            m_ctu;
+    int               m_ctuSize  = 0;
+    int               m_gridSize = 0;
+    std::vector<Cell> m_cells;
+};
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include "MotionPyramid.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace CAROL {
+
+// Média 2x2 (com arredondamento); a última linha/coluna ímpar é descartada
+void MotionPyramid::xDownsample(const Pel* src, int srcStride, int srcWidth, int srcHeight, Plane& dst) {
+    dst.width  = srcWidth >> 1;
+    dst.height = srcHeight >> 1;
+    dst.samples.resize((size_t)dst.width * dst.height);
+
+    for (int y = 0; y < dst.height; y++) {
+        const Pel* row0 = src + (2 * y) * srcStride;
+        const Pel* row1 = row0 + srcStride;
+        Pel*       out  = dst.samples.data() + y * dst.width;
+        for (int x = 0; x < dst.width; x++) {
+            out[x] = (Pel)((row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+        }
+    }
+}
+
+const MotionPyramid::Entry& MotionPyramid::xGetPlanes(const Picture& pic, bool orig) {
+    for (auto it = m_planes.begin(); it != m_planes.end(); ++it) {
+        if (it->pic == &pic && it->poc == pic.getPOC() && it->orig == orig) {
+            m_planes.splice(m_planes.begin(), m_planes, it);
+            return m_planes.front();
+        }
+    }
+
+    if ((int)m_planes.size() >= MAX_PICTURES) {
+        m_planes.pop_back();
+    }
+    m_planes.emplace_front();
+    Entry& entry = m_planes.front();
+    entry.pic  = &pic;
+    entry.poc  = pic.getPOC();
+    entry.orig = orig;
+
+    const CPelBuf luma = orig ? pic.getOrigBuf().Y() : pic.getRecoBuf().Y();
+    xDownsample(luma.buf, luma.stride, luma.width, luma.height, entry.level[0]);
+    const Plane& half = entry.level[0];
+    xDownsample(half.samples.data(), half.width, half.width, half.height, entry.level[1]);
+    return entry;
+}
+
+uint64_t MotionPyramid::xSad(const Plane& org, const Plane& ref, int x, int y, int w, int h, int dx, int dy) {
+    uint64_t sad = 0;
+    for (int j = 0; j < h; j++) {
+        const Pel* o = org.at(x, y + j);
+        const Pel* r = ref.at(x + dx, y + j + dy);
+        for (int i = 0; i < w; i++) {
+            sad += std::abs(o[i] - r[i]);
+        }
+    }
+    return sad;
+}
+
+// Busca completa em [cx-range, cx+range] x [cy-range, cy+range], restrita à área válida da referência
+void MotionPyramid::xSearch(const Plane& org, const Plane& ref, int x, int y, int w, int h, int cx, int cy, int range,
+                            int& bestX, int& bestY, uint64_t& bestSad) {
+    const int minX = std::max(cx - range, -x);
+    const int maxX = std::min(cx + range, ref.width - w - x);
+    const int minY = std::max(cy - range, -y);
+    const int maxY = std::min(cy + range, ref.height - h - y);
+
+    bestSad = std::numeric_limits<uint64_t>::max();
+    bestX   = 0;
+    bestY   = 0;
+    for (int dy = minY; dy <= maxY; dy++) {
+        for (int dx = minX; dx <= maxX; dx++) {
+            const uint64_t sad = xSad(org, ref, x, y, w, h, dx, dy);
+            // em empate, prefere o vetor mais curto
+            if (sad < bestSad || (sad == bestSad && std::abs(dx) + std::abs(dy) < std::abs(bestX) + std::abs(bestY))) {
+                bestSad = sad;
+                bestX   = dx;
+                bestY   = dy;
+            }
+        }
+    }
+}
+
+bool MotionPyramid::getCtuMv(const Picture& cur, const Picture& ref, int ctuX, int ctuY, int ctuSize, int searchRange, CtuMv& ctuMv) {
+    if (&cur != m_curPic || cur.getPOC() != m_curPoc) {
+        m_ctuMvs.clear();
+        m_curPic = &cur;
+        m_curPoc = cur.getPOC();
+    }
+
+    const uint64_t key = ((uint64_t)(uint32_t)ref.getPOC() << 32) ^ ((uint64_t)ref.layerId << 56)
+                       ^ ((uint64_t)(ctuY & 0xffff) << 16) ^ (uint64_t)(ctuX & 0xffff);
+    auto it = m_ctuMvs.find(key);
+    if (it != m_ctuMvs.end()) {
+        ctuMv = it->second;
+        return true;
+    }
+
+    const Entry& orgPyr = xGetPlanes(cur, true);
+    const Entry& refPyr = xGetPlanes(ref, false);
+    if (orgPyr.level[0].width != refPyr.level[0].width || orgPyr.level[0].height != refPyr.level[0].height) {
+        return false;   // referência reescalada (RPR)
+    }
+
+    // nível 1 (1/4 por dimensão): busca completa em torno do vetor zero
+    const Plane& org1 = orgPyr.level[1];
+    const Plane& ref1 = refPyr.level[1];
+    const int x1 = (ctuX * ctuSize) >> 2;
+    const int y1 = (ctuY * ctuSize) >> 2;
+    const int w1 = std::min(ctuSize >> 2, org1.width - x1);
+    const int h1 = std::min(ctuSize >> 2, org1.height - y1);
+    if (w1 <= 0 || h1 <= 0) {
+        return false;
+    }
+    int mvX1, mvY1;
+    uint64_t sad1;
+    xSearch(org1, ref1, x1, y1, w1, h1, 0, 0, std::max(1, searchRange >> 2), mvX1, mvY1, sad1);
+
+    // nível 0 (1/2 por dimensão): refinamento em torno do vetor escalado
+    const Plane& org0 = orgPyr.level[0];
+    const Plane& ref0 = refPyr.level[0];
+    const int x0 = (ctuX * ctuSize) >> 1;
+    const int y0 = (ctuY * ctuSize) >> 1;
+    const int w0 = std::min(ctuSize >> 1, org0.width - x0);
+    const int h0 = std::min(ctuSize >> 1, org0.height - y0);
+    int mvX0, mvY0;
+    uint64_t sad0;
+    xSearch(org0, ref0, x0, y0, w0, h0, 2 * mvX1, 2 * mvY1, REFINE_RANGE, mvX0, mvY0, sad0);
+    if (sad0 == std::numeric_limits<uint64_t>::max()) {
+        return false;
+    }
+
+    ctuMv.hor          = 2 * mvX0;
+    ctuMv.ver          = 2 * mvY0;
+    ctuMv.sadPerSample = (double)sad0 / (double)(w0 * h0);
+    m_ctuMvs[key] = ctuMv;
+    return true;
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef __MOTION_PYRAMID_H__
+#define __MOTION_PYRAMID_H__
+
+#include "CommonLib/Picture.h"
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace CAROL {
+
+// Pirâmide de luma subamostrada (nível 0: 1/2 por dimensão = 1/4 da área, nível 1: 1/4 por dimensão = 1/16)
+// do original e das referências, construída uma vez por imagem. Uma busca coarse-to-fine por CTU gera
+// um vetor inteiro que é injetado como candidato inicial do xTZSearch.
+class MotionPyramid {
+public:
+    static const int NUM_LEVELS   = 2;
+    static const int MAX_PICTURES = 17;   // limite de imagens com pirâmide em memória (LRU)
+    static const int REFINE_RANGE = 2;    // refinamento no nível 0 em torno do vetor do nível 1
+
+    struct CtuMv {
+        int    hor = 0;           // vetor em amostras inteiras de luma
+        int    ver = 0;
+        double sadPerSample = 0;  // SAD médio do casamento no nível 0 (confiabilidade)
+    };
+
+    // Vetor da CTU (ctuX, ctuY) de cur em relação a ref; calculado na primeira consulta.
+    // Retorna false quando a pirâmide não se aplica (p.ex. referência com resolução diferente).
+    bool getCtuMv(const Picture& cur, const Picture& ref, int ctuX, int ctuY, int ctuSize, int searchRange, CtuMv& ctuMv);
+
+private:
+    struct Plane {
+        std::vector<Pel> samples;
+        int width  = 0;
+        int height = 0;
+        const Pel* at(int x, int y) const { return samples.data() + y * width + x; }
+    };
+
+    struct Entry {
+        const Picture* pic = nullptr;
+        int            poc = 0;
+        bool           orig = false;
+        Plane          level[NUM_LEVELS];
+    };
+
+    const Entry& xGetPlanes(const Picture& pic, bool orig);
+
+    static void xDownsample(const Pel* src, int srcStride, int srcWidth, int srcHeight, Plane& dst);
+    static uint64_t xSad(const Plane& org, const Plane& ref, int x, int y, int w, int h, int dx, int dy);
+    static void xSearch(const Plane& org, const Plane& ref, int x, int y, int w, int h, int cx, int cy, int range,
+                        int& bestX, int& bestY, uint64_t& bestSad);
+
+    std::list<Entry> m_planes;                        // mais recente na frente
+    std::unordered_map<uint64_t, CtuMv> m_ctuMvs;     // (POC ref, CTU) -> vetor, da imagem atual
+    const Picture* m_curPic = nullptr;
+    int            m_curPoc = -1;
+};
+
+}
+
+#endif
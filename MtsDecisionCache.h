@@ -0,0 +1,66 @@
+#ifndef __MTS_DECISION_CACHE_H__
+#define __MTS_DECISION_CACHE_H__
+
+#include "CommonLib/Buffer.h"
+#include "CommonLib/Unit.h"
+#include "CtuScope.h"
+#include <cstdint>
+#include <unordered_map>
+
+namespace CAROL {
+
+// Cache das decisões de MTS por CTU, indexado por (área, hash do resíduo).
+// encodeResAndCalcRdInterCU é chamado muitas vezes para a mesma área (merge, AMVP, affine, SBT, ACT);
+// quando o resíduo se repete, o vencedor anterior é testado e os demais candidatos MTS são pulados.
+class MtsDecisionCache {
+public:
+    struct Entry {
+        MtsType mtsIdx;   // transformada vencedora
+        int     rank;     // posição do vencedor na lista de candidatos testados
+    };
+
+    // Limpa o cache ao mudar de CTU
+    void enterCtu(const CtuTag& tag) {
+        if (tag != m_ctu) {
+            m_entries.clear();
+            m_ctu = tag;
+        }
+    }
+
+    // Hash do resíduo; resiShift > 0 agrupa resíduos "muito parecidos" na mesma chave
+    static uint64_t hashResidual(const CPelBuf& resi, int resiShift) {
+        uint64_t h = 1469598103934665603ull; // FNV-1a
+        for (int y = 0; y < resi.height; y++) {
+            const Pel* row = resi.bufAt(0, y);
+            for (int x = 0; x < resi.width; x++) {
+                h ^= (uint64_t)(uint16_t)(row[x] >> resiShift);
+                h *= 1099511628211ull;
+            }
+        }
+        return h;
+    }
+
+    static uint64_t makeKey(const CompArea& area, int qp, bool colorTrans, uint64_t resiHash) {
+        uint64_t k = resiHash;
+        k ^= ((uint64_t)area.x << 48) ^ ((uint64_t)area.y << 32) ^ ((uint64_t)area.width << 20) ^ ((uint64_t)area.height << 8);
+        k ^= ((uint64_t)(qp & 0x7f) << 1) ^ (uint64_t)colorTrans;
+        return k;
+    }
+
+    const Entry* find(uint64_t key) const {
+        auto it = m_entries.find(key);
+        return it == m_entries.end() ? nullptr : &it->second;
+    }
+
+    void store(uint64_t key, MtsType mtsIdx, int rank) {
+        m_entries[key] = Entry{ mtsIdx, rank };
+    }
+
+private:
+    CtuTag                              m_ctu;
+    std::unordered_map<uint64_t, Entry> m_entries;
+};
+
+}
+
+#endif
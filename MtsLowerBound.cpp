@@ -0,0 +1,87 @@
+#include "MtsLowerBound.h"
+
+#include "CommonLib/Rom.h"
+#include "CommonLib/TrQuant_EMT.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CAROL {
+
+typedef void FwdTrans(const TCoeff*, TCoeff*, int, int, int, int);
+
+// Núcleos de 4 a 32 pontos por log2 do tamanho (o MTS inter não passa de 32x32)
+static FwdTrans* const s_fwdDST7[6] = { nullptr, nullptr, fastForwardDST7_B4, fastForwardDST7_B8, fastForwardDST7_B16, fastForwardDST7_B32 };
+static FwdTrans* const s_fwdDCT8[6] = { nullptr, nullptr, fastForwardDCT8_B4, fastForwardDCT8_B8, fastForwardDCT8_B16, fastForwardDCT8_B32 };
+
+double mtsCostLowerBound(const CPelBuf& resi, MtsType mtsIdx, const MtsBoundParams& params) {
+    const int width      = resi.width;
+    const int height     = resi.height;
+    const int log2Width  = floorLog2(width);
+    const int log2Height = floorLog2(height);
+    CHECK(log2Width < 2 || log2Width > 5 || log2Height < 2 || log2Height > 5, "MTS block size out of range");
+
+    // mesmo mapeamento do TrQuant::getTrTypes para o MTS explícito
+    const int       idx        = (int)mtsIdx - (int)MtsType::DST7_DST7;
+    FwdTrans* const trHor      = (idx & 1) ? s_fwdDCT8[log2Width] : s_fwdDST7[log2Width];
+    FwdTrans* const trVer      = (idx >> 1) ? s_fwdDCT8[log2Height] : s_fwdDST7[log2Height];
+    const int       skipWidth  = width == 32 ? 16 : 0;
+    const int       skipHeight = height == 32 ? 16 : 0;
+
+    TCoeff   block[32 * 32];
+    TCoeff   tmp[32 * 32];
+    TCoeff   coeff[32 * 32];
+    uint64_t resiEnergy = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const TCoeff r = resi.at(x, y);
+            block[y * width + x] = r;
+            resiEnergy += (uint64_t)((int64_t)r * r);
+        }
+    }
+
+    const int matrixShift = g_transformMatrixShift[TRANSFORM_FORWARD];
+    const int shift1st    = log2Width + params.bitDepth + matrixShift - params.maxLog2TrDynamicRange + COM16_C806_TRANS_PREC;
+    const int shift2nd    = log2Height + matrixShift + COM16_C806_TRANS_PREC;
+    trHor(block, tmp, shift1st, height, 0, skipWidth);
+    trVer(tmp, coeff, shift2nd, width, skipWidth, skipHeight);
+
+    // ganho da transformada direta: 2^(maxLog2TrDynamicRange - bitDepth) / sqrt(largura * altura)
+    const double pixelDomainScale = (double)(width * height)
+                                    / std::ldexp(1.0, 2 * (params.maxLog2TrDynamicRange - params.bitDepth) + params.distShift);
+    const double distScale = params.costPerDist * pixelDomainScale;
+
+    double   bound       = 0;
+    double   keptEnergy  = 0;
+    double   largestTerm = 0;
+    for (int cgY = 0; cgY < height; cgY += 4) {
+        for (int cgX = 0; cgX < width; cgX += 4) {
+            double cgSum = 0;
+            double cgMax = 0;
+            for (int y = cgY; y < cgY + 4; y++) {
+                for (int x = cgX; x < cgX + 4; x++) {
+                    const TCoeff c      = coeff[y * width + x];
+                    const double energy = (double)c * c;
+                    const double term   = std::min(energy * distScale, params.costPerBit);
+                    keptEnergy += energy;
+                    cgSum      += term;
+                    cgMax       = std::max(cgMax, term);
+                }
+            }
+            // com sign hiding o sinal de um coeficiente do grupo não é transmitido
+            bound      += params.signHiding ? cgSum - cgMax : cgSum;
+            largestTerm = std::max(largestTerm, cgMax);
+        }
+    }
+    if (!params.signHiding) {
+        // pelo menos um coeficiente não nulo paga o bit de sinal
+        bound += std::max(0.0, params.costPerBit - largestTerm);
+    }
+    if (skipWidth || skipHeight) {
+        const double lostEnergy = (double)resiEnergy / std::ldexp(1.0, params.distShift) - keptEnergy * pixelDomainScale;
+        bound += params.costPerDist * std::max(0.0, lostEnergy);
+    }
+    return bound;
+}
+
+}
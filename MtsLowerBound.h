@@ -0,0 +1,29 @@
+#ifndef __MTS_LOWER_BOUND_H__
+#define __MTS_LOWER_BOUND_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CommonLib/Buffer.h"
+#include <cstdint>
+
+namespace CAROL {
+
+// Constantes do bloco para o limite inferior de custo dos candidatos MTS
+struct MtsBoundParams {
+    int      bitDepth;
+    int      maxLog2TrDynamicRange;
+    uint32_t distShift;     // mesmo deslocamento do SSE do getDistPart
+    double   costPerDist;   // calcRdCost(0, 1)
+    double   costPerBit;    // calcRdCost(1 << SCALE_BITS, 0)
+    bool     signHiding;    // um sinal por grupo de 4x4 coeficientes pode sair de graça
+};
+
+// Limite inferior do custo RD de um candidato MTS (DST7/DCT8) que termine com coeficientes não nulos.
+// O resíduo passa pelos mesmos núcleos rápidos do TrQuant::xT (os coeficientes cuja soma absoluta é a SATD
+// com que o transformNxN filtra os candidatos). Pela identidade de Parseval cada coeficiente custa pelo menos
+// o menor entre a sua energia (quantizado para zero) e um bit (o sinal em bypass, se não nulo); a energia
+// que o zero-out das transformadas de 32 pontos descarta entra inteira.
+double mtsCostLowerBound(const CPelBuf& resi, MtsType mtsIdx, const MtsBoundParams& params);
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "OrgFeatureCache.h"
+
+namespace CAROL {
+
+void OrgFeatureCache::setMaxEntries(size_t maxEntries) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxEntries = maxEntries;
+    m_numEntries = 0;
+    m_pictures.clear();
+    m_order.clear();
+}
+
+BlockFeatures OrgFeatureCache::get(const std::string& inputName, int poc, int x, int y, int w, int h, const cv::Mat& blk) {
+    if (!isEnabled()) {
+        return extract_org_features(blk);
+    }
+
+    const uint64_t key = ((uint64_t)(x & 0xffff) << 48) | ((uint64_t)(y & 0xffff) << 32)
+                       | ((uint64_t)(w & 0xffff) << 16) | (uint64_t)(h & 0xffff);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (inputName != m_inputName) {
+            m_inputName  = inputName;
+            m_numEntries = 0;
+            m_pictures.clear();
+            m_order.clear();
+        }
+        auto pic = m_pictures.find(poc);
+        if (pic != m_pictures.end()) {
+            auto it = pic->second.find(key);
+            if (it != pic->second.end()) {
+                return it->second;
+            }
+        }
+    }
+
+    // calculado fora do lock; dois codificadores no mesmo bloco só repetem o cálculo
+    const BlockFeatures feats = extract_org_features(blk);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto pic = m_pictures.find(poc);
+    if (pic == m_pictures.end()) {
+        pic = m_pictures.emplace(poc, PictureMap()).first;
+        m_order.push_back(poc);
+    }
+    if (pic->second.emplace(key, feats).second) {
+        m_numEntries++;
+    }
+    while (m_numEntries > m_maxEntries && m_order.size() > 1) {
+        auto oldest = m_pictures.find(m_order.front());
+        m_numEntries -= oldest->second.size();
+        m_pictures.erase(oldest);
+        m_order.pop_front();
+    }
+    return feats;
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef __ORG_FEATURE_CACHE_H__
+#define __ORG_FEATURE_CACHE_H__
+
+#include "BlockFeatures.h"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace CAROL {
+
+// Features do bloco original (extract_org_features) por (POC, x, y, w, h), compartilhadas entre os
+// codificadores do modo multi-QP: o primeiro QP que avalia um bloco calcula, os demais reaproveitam.
+// As imagens entram em grupos; passando de maxEntries, as mais antigas saem inteiras.
+// Só vale para um original igual em todos os QPs: com o filtro temporal do GOP (força dependente do QP) o
+// InterSearch não consulta a cache.
+class OrgFeatureCache {
+public:
+    static OrgFeatureCache& getInstance() {
+        static OrgFeatureCache instance;
+        return instance;
+    }
+
+    // 0 desliga a cache (padrão fora do modo multi-QP)
+    void setMaxEntries(size_t maxEntries);
+    bool isEnabled() const { return m_maxEntries > 0; }
+
+    // Features do bloco; calcula e guarda na primeira vez
+    BlockFeatures get(const std::string& inputName, int poc, int x, int y, int w, int h, const cv::Mat& blk);
+
+    OrgFeatureCache(const OrgFeatureCache&) = delete;
+    void operator=(const OrgFeatureCache&) = delete;
+
+private:
+    OrgFeatureCache() {}
+
+    typedef std::unordered_map<uint64_t, BlockFeatures> PictureMap;
+
+    std::mutex                          m_mutex;
+    size_t                              m_maxEntries = 0;
+    size_t                              m_numEntries = 0;
+    std::string                         m_inputName;
+    std::unordered_map<int, PictureMap> m_pictures;
+    std::deque<int>                     m_order;    // POCs na ordem de entrada
+};
+
+}
+
+#endif
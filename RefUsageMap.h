@@ -0,0 +1,68 @@
+#ifndef __REF_USAGE_MAP_H__
+#define __REF_USAGE_MAP_H__
+
+#include "CommonLib/CommonDef.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace CAROL {
+
+// Quantas vezes cada refIdx foi o escolhido pelo predInterSearch em cada CTU da imagem, por lista.
+// A ordem de teste das referências de um PU começa pelas mais votadas na CTU atual e nas vizinhas
+// (esquerda e acima) e desempata pela distância de POC.
+class RefUsageMap {
+public:
+    // Limpa as contagens ao mudar de imagem (ou de codificador, no modo multi-QP)
+    void enterPicture(int poc, int layerId, int instance, int widthInCtus, int heightInCtus) {
+        if (poc != m_poc || layerId != m_layerId || instance != m_instance || widthInCtus != m_widthInCtus
+            || heightInCtus != m_heightInCtus) {
+            m_poc          = poc;
+            m_layerId      = layerId;
+            m_instance     = instance;
+            m_widthInCtus  = widthInCtus;
+            m_heightInCtus = heightInCtus;
+            m_counts.assign((size_t)widthInCtus * heightInCtus * NUM_REF_PIC_LIST_01 * MAX_NUM_REF, 0);
+        }
+    }
+
+    void record(int ctuX, int ctuY, int list, int refIdx) {
+        uint16_t& count = m_counts[xIndex(ctuX, ctuY, list) + refIdx];
+        if (count < UINT16_MAX) count++;
+    }
+
+    // refIdx da lista em ordem de teste; pocDist[i] é a distância |POC atual - POC da referência i|
+    void rank(int ctuX, int ctuY, int list, int numRef, const int* pocDist, int order[MAX_NUM_REF]) const {
+        int votes[MAX_NUM_REF] = { 0 };
+        const int neighbours[3][2] = { { ctuX, ctuY }, { ctuX - 1, ctuY }, { ctuX, ctuY - 1 } };
+        for (const auto& n : neighbours) {
+            if (n[0] < 0 || n[1] < 0 || n[0] >= m_widthInCtus || n[1] >= m_heightInCtus) continue;
+            const uint16_t* counts = m_counts.data() + xIndex(n[0], n[1], list);
+            for (int i = 0; i < numRef; i++) {
+                votes[i] += counts[i];
+            }
+        }
+        for (int i = 0; i < numRef; i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order, order + numRef, [&](int a, int b) {
+            return votes[a] != votes[b] ? votes[a] > votes[b] : pocDist[a] < pocDist[b];
+        });
+    }
+
+private:
+    size_t xIndex(int ctuX, int ctuY, int list) const {
+        return ((size_t)(ctuY * m_widthInCtus + ctuX) * NUM_REF_PIC_LIST_01 + list) * MAX_NUM_REF;
+    }
+
+    int                   m_poc          = -1;
+    int                   m_layerId      = -1;
+    int                   m_instance     = -1;
+    int                   m_widthInCtus  = 0;
+    int                   m_heightInCtus = 0;
+    std::vector<uint16_t> m_counts;
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include "SbtDistortionMap.h"
+
+#include <algorithm>
+
+#if ENABLE_SIMD_OPT && !RExt__HIGH_BIT_DEPTH_SUPPORT
+#include <emmintrin.h>
+#endif
+
+namespace CAROL {
+
+// (org - pred)^2 >> shift de uma linha
+static void xSquaredDiffRow(const Pel* org, const Pel* pred, int width, uint32_t shift, uint32_t* out) {
+    int x = 0;
+#if ENABLE_SIMD_OPT && !RExt__HIGH_BIT_DEPTH_SUPPORT
+    // Pel de 16 bits: a diferença cabe em int16 e o quadrado sai em 32 bits de mullo/mulhi intercalados
+    const __m128i vShift = _mm_cvtsi32_si128((int)shift);
+    for (; x + 8 <= width; x += 8) {
+        const __m128i d  = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)(org + x)), _mm_loadu_si128((const __m128i*)(pred + x)));
+        const __m128i lo = _mm_mullo_epi16(d, d);
+        const __m128i hi = _mm_mulhi_epi16(d, d);
+        _mm_storeu_si128((__m128i*)(out + x), _mm_srl_epi32(_mm_unpacklo_epi16(lo, hi), vShift));
+        _mm_storeu_si128((__m128i*)(out + x + 4), _mm_srl_epi32(_mm_unpackhi_epi16(lo, hi), vShift));
+    }
+#endif
+    for (; x < width; x++) {
+        const Intermediate_Int d = org[x] - pred[x];
+        out[x] = (uint32_t)((d * d) >> shift);
+    }
+}
+
+void SbtDistortionMap::build(ComponentID compID, const CPelBuf& org, const CPelBuf& pred, uint32_t shift) {
+    const int width  = org.width;
+    const int height = org.height;
+    const int stride = width + 1;
+
+    std::vector<uint64_t>& sum = m_sum[compID];
+    sum.resize((size_t)stride * (height + 1));
+    m_stride[compID] = stride;
+    m_row.resize(width);
+    std::fill(sum.begin(), sum.begin() + stride, 0);
+
+    for (int y = 0; y < height; y++) {
+        xSquaredDiffRow(org.bufAt(0, y), pred.bufAt(0, y), width, shift, m_row.data());
+        const uint64_t* above = sum.data() + y * stride;
+        uint64_t*       cur   = sum.data() + (y + 1) * stride;
+        uint64_t        run   = 0;
+        cur[0] = 0;
+        for (int x = 0; x < width; x++) {
+            run       += m_row[x];
+            cur[x + 1] = above[x + 1] + run;
+        }
+    }
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef __SBT_DISTORTION_MAP_H__
+#define __SBT_DISTORTION_MAP_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CommonLib/Buffer.h"
+#include <cstdint>
+#include <vector>
+
+namespace CAROL {
+
+// Somas de prefixo 2D do SSE org - pred de um CU, por componente: cada amostra contribui com
+// (org - pred)^2 >> shift, como no laço do calcMinDistSbt. A distorção de qualquer retângulo do
+// componente (metades e quartos do SBT, TUs parciais) sai de quatro leituras.
+class SbtDistortionMap {
+public:
+    // Uma passada pelo bloco do componente (diferença ao quadrado em SIMD quando disponível)
+    void build(ComponentID compID, const CPelBuf& org, const CPelBuf& pred, uint32_t shift);
+
+    // SSE do retângulo (x, y, width, height) em amostras do componente, relativo ao canto do CU
+    Distortion rect(ComponentID compID, int x, int y, int width, int height) const {
+        const uint64_t* s      = m_sum[compID].data();
+        const int       stride = m_stride[compID];
+        return (Distortion)(s[(y + height) * stride + x + width] - s[y * stride + x + width]
+                            - s[(y + height) * stride + x] + s[y * stride + x]);
+    }
+
+private:
+    std::vector<uint64_t> m_sum[MAX_NUM_COMPONENT];   // (height + 1) x (width + 1), linha e coluna 0 zeradas
+    int                   m_stride[MAX_NUM_COMPONENT] = { 0 };
+    std::vector<uint32_t> m_row;
+};
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "SpeedupStats.h"
+
+namespace CAROL {
+
+// Cada linha do relatório: total de testes e quantos foram atalhados
+struct StatLine {
+    const char* label;
+    StatId      total;
+    StatId      hits;
+    const char* totalName;
+    const char* hitsName;
+};
+
+static const StatLine g_statLines[] = {
+    { "MTS early termination", StatId::MTS_ET_CHECKED, StatId::MTS_ET_SKIPPED, "checked", "skipped" },
+    { "MTS decision cache",    StatId::MTS_CACHE_LOOKUPS, StatId::MTS_CACHE_HITS, "lookups", "hits" },
+    { "Motion pyramid",        StatId::PYRAMID_SEARCHES, StatId::PYRAMID_RASTER_SKIPPED, "TZ searches", "no raster" },
+    { "CTU motion field cache", StatId::MOTION_FIELD_SEEDED, StatId::MOTION_FIELD_PRUNED, "seeded", "no raster" },
+    { "Predictive frac. refine", StatId::FRAC_REFINE_CANDIDATES, StatId::FRAC_REFINE_SKIPPED, "candidates", "skipped" },
+    { "Sub-pel surface fit",   StatId::SUB_PEL_FIT_SEARCHES, StatId::SUB_PEL_FIT_USED, "searches", "fitted" },
+    { "Batched TZ pattern SAD", StatId::TZ_BATCH_CANDIDATES, StatId::TZ_BATCH_EVALUATED, "points", "batched" },
+    { "Affine GN convergence",   StatId::AFFINE_GN_ITERATIONS, StatId::AFFINE_GN_CONVERGED, "iterations", "converged" },
+    { "Affine model index",      StatId::AFFINE_INDEX_LOOKUPS, StatId::AFFINE_INDEX_SKIPPED, "lookups", "no iterations" },
+    { "Affine likelihood pre-test", StatId::AFFINE_PRETEST_CHECKED, StatId::AFFINE_PRETEST_SKIPPED, "checked", "skipped" },
+    { "SMVD pair cache",         StatId::SMVD_PAIRS, StatId::SMVD_PAIRS_REUSED, "pairs", "reused" },
+    { "IBC rolling-hash index",  StatId::IBC_HASH_LOOKUPS, StatId::IBC_HASH_EXACT, "lookups", "exact" },
+    { "Reference early term.",   StatId::REF_ME_TESTED, StatId::REF_ME_SKIPPED, "refs", "ME skipped" },
+};
+
+void SpeedupStats::report(FILE* fp) const {
+    bool headerPrinted = false;
+
+    for (const auto& line : g_statLines) {
+        const uint64_t total = get(line.total);
+        if (total == 0) continue; // atalho não exercitado
+
+        if (!headerPrinted) {
+            fprintf(fp, "\n CAROL speed-up statistics\n");
+            headerPrinted = true;
+        }
+        const uint64_t hits = get(line.hits);
+        fprintf(fp, "  %-28s: %12llu %-10s %12llu %-10s (%6.2f %%)\n", line.label,
+                (unsigned long long)total, line.totalName, (unsigned long long)hits, line.hitsName,
+                100.0 * (double)hits / (double)total);
+    }
+
+    // média de iterações do bi-pred adaptativo por tamanho de bloco
+    bool biPredHeaderPrinted = false;
+    for (int w = 0; w <= MAX_LOG2_SIZE; w++) {
+        for (int h = 0; h <= MAX_LOG2_SIZE; h++) {
+            const uint64_t blocks = m_biPredBlocks[w][h].load(std::memory_order_relaxed);
+            if (blocks == 0) continue;
+
+            if (!headerPrinted) {
+                fprintf(fp, "\n CAROL speed-up statistics\n");
+                headerPrinted = true;
+            }
+            if (!biPredHeaderPrinted) {
+                fprintf(fp, "  %-28s:\n", "Adaptive bi-pred iterations");
+                biPredHeaderPrinted = true;
+            }
+            const uint64_t iters = m_biPredIters[w][h].load(std::memory_order_relaxed);
+            fprintf(fp, "    %3dx%-3d %12llu blocks     %6.2f iterations/block\n", 1 << w, 1 << h,
+                    (unsigned long long)blocks, (double)iters / (double)blocks);
+        }
+    }
+}
+
+}
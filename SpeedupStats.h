@@ -0,0 +1,101 @@
+#ifndef __SPEEDUP_STATS_H__
+#define __SPEEDUP_STATS_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+namespace CAROL {
+
+// Contadores dos atalhos de complexidade do InterSearch
+enum class StatId : int {
+    MTS_ET_CHECKED = 0,   // candidatos MTS submetidos ao limite inferior
+    MTS_ET_SKIPPED,       // candidatos MTS descartados pelo limite inferior
+    MTS_CACHE_LOOKUPS,    // consultas ao cache de decisões MTS
+    MTS_CACHE_HITS,       // consultas que reaproveitaram a decisão anterior
+    PYRAMID_SEARCHES,     // buscas TZ com candidato da pirâmide
+    PYRAMID_RASTER_SKIPPED, // buscas TZ em que o raster foi pulado
+    MOTION_FIELD_SEEDED,  // buscas TZ com candidatos do campo de movimento da CTU
+    MOTION_FIELD_PRUNED,  // buscas TZ em que o campo confirmou o vetor e o raster foi pulado
+    FRAC_REFINE_CANDIDATES, // candidatos fracionários dos refinamentos no modo preditivo (9 por passo)
+    FRAC_REFINE_SKIPPED,  // candidatos fracionários podados pelo limite inferior do modelo
+    SUB_PEL_FIT_SEARCHES, // buscas fracionárias com o modo de ajuste da superfície ligado
+    SUB_PEL_FIT_USED,     // buscas resolvidas pelo ajuste (sem as passadas de meia e um quarto de amostra)
+    TZ_BATCH_CANDIDATES,  // pontos dos padrões quadrado/diamante do TZ
+    TZ_BATCH_EVALUATED,   // pontos cujo SAD saiu do cálculo em lote
+    AFFINE_GN_ITERATIONS, // iterações Gauss-Newton da ME afim com o teste de convergência
+    AFFINE_GN_CONVERGED,  // ME afim encerrada pelo tamanho da atualização
+    AFFINE_INDEX_LOOKUPS, // referências de CUs afins com modelos da CTU na grade 8x8
+    AFFINE_INDEX_SKIPPED, // ME afim sem iterações (modelo herdado abaixo do limiar de SATD)
+    AFFINE_PRETEST_CHECKED, // CUs com busca afim submetidos ao pré-teste dos quadrantes
+    AFFINE_PRETEST_SKIPPED, // CUs sem busca afim (modelo translacional adequado)
+    SMVD_PAIRS,           // distorções de pares simétricos pedidas na busca SMVD
+    SMVD_PAIRS_REUSED,    // pares cuja distorção já estava na cache da busca
+    IBC_HASH_LOOKUPS,     // consultas ao índice de hash do IBC
+    IBC_HASH_EXACT,       // consultas com cópia exata do bloco (varreduras dispensadas)
+    REF_ME_TESTED,        // referências (lista, refIdx) consideradas no AMVP uni-direcional
+    REF_ME_SKIPPED,       // MEs dispensadas pelo término antecipado por referência
+    NUM
+};
+
+class SpeedupStats {
+private:
+    static const int MAX_LOG2_SIZE = 7;
+
+    std::atomic<uint64_t> m_counters[(int)StatId::NUM];
+    // blocos e iterações do refinamento bi-pred adaptativo por [log2 largura][log2 altura]
+    std::atomic<uint64_t> m_biPredBlocks[MAX_LOG2_SIZE + 1][MAX_LOG2_SIZE + 1];
+    std::atomic<uint64_t> m_biPredIters[MAX_LOG2_SIZE + 1][MAX_LOG2_SIZE + 1];
+
+    // Construtor privado
+    SpeedupStats() {
+        for (auto& c : m_counters) c = 0;
+        for (int w = 0; w <= MAX_LOG2_SIZE; w++) {
+            for (int h = 0; h <= MAX_LOG2_SIZE; h++) {
+                m_biPredBlocks[w][h] = 0;
+                m_biPredIters[w][h]  = 0;
+            }
+        }
+    }
+
+public:
+    // Retorna a instância única
+    static SpeedupStats& getInstance() {
+        static SpeedupStats instance;
+        return instance;
+    }
+
+    void add(StatId id, uint64_t n = 1) {
+        m_counters[(int)id].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t get(StatId id) const {
+        return m_counters[(int)id].load(std::memory_order_relaxed);
+    }
+
+    // Iterações L0/L1 feitas pelo refinamento bi-pred de um bloco width x height (luma)
+    void addBiPredIterations(int width, int height, int iterations) {
+        const int w = xLog2(width);
+        const int h = xLog2(height);
+        m_biPredBlocks[w][h].fetch_add(1, std::memory_order_relaxed);
+        m_biPredIters[w][h].fetch_add(iterations, std::memory_order_relaxed);
+    }
+
+    // Imprime o resumo dos contadores (chamado ao final do encmain)
+    void report(FILE* fp) const;
+
+    // Deletar cópia e atribuição para garantir Singleton
+    SpeedupStats(const SpeedupStats&) = delete;
+    void operator=(const SpeedupStats&) = delete;
+
+private:
+    static int xLog2(int size) {
+        int log2 = 0;
+        while (log2 < MAX_LOG2_SIZE && (2 << log2) <= size) log2++;
+        return log2;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include "SubPelPlanes.h"
+
+#include <algorithm>
+
+namespace CAROL {
+
+const SubPelPlanes::Planes* SubPelPlanes::get(const Picture& ref, const ClpRng& clpRng, int maxPictures, WorkerPool* pool) {
+    if (maxPictures <= 0) {
+        return nullptr;
+    }
+
+    for (auto it = m_planes.begin(); it != m_planes.end(); ++it) {
+        if (it->pic == &ref && it->poc == ref.getPOC() && it->layerId == ref.layerId) {
+            m_planes.splice(m_planes.begin(), m_planes, it);
+            return &m_planes.front();
+        }
+    }
+
+    while ((int)m_planes.size() >= maxPictures) {
+        m_planes.pop_back();
+    }
+    m_planes.emplace_front();
+    Planes& planes = m_planes.front();
+    planes.pic     = &ref;
+    planes.poc     = ref.getPOC();
+    planes.layerId = ref.layerId;
+    xBuild(planes, clpRng, pool);
+    return &planes;
+}
+
+void SubPelPlanes::xBuild(Planes& planes, const ClpRng& clpRng, WorkerPool* pool) const {
+    const CPelBuf reco = planes.pic->getRecoBuf().Y();
+    const int halfFilterSize = NTAPS_LUMA >> 1;
+
+    // os filtros leem halfFilterSize amostras além da área coberta: a extensão fica dentro da margem
+    planes.ext    = std::max(0, planes.pic->margin - 2 * halfFilterSize);
+    planes.width  = reco.width;
+    planes.height = reco.height;
+
+    const int planeWidth  = reco.width + 2 * planes.ext;
+    const int planeHeight = reco.height + 2 * planes.ext;
+    planes.stride = planeWidth;
+    for (int fy = 0; fy < 4; fy++) {
+        for (int fx = 0; fx < 4; fx++) {
+            if (fx != 0 || fy != 0) {
+                planes.samples[fy][fx].resize((size_t)planeWidth * planeHeight);
+            }
+        }
+    }
+
+    // cada faixa de linhas é independente: filtro horizontal das 4 fases num buffer local e vertical por cima
+    const int numBands = (planeHeight + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    auto buildBand = [&](int band) {
+        const int y0         = band * BAND_HEIGHT;
+        const int bandHeight = std::min(BAND_HEIGHT, planeHeight - y0);
+        const int tmpHeight  = bandHeight + NTAPS_LUMA - 1;
+
+        std::vector<Pel> tmp((size_t)planeWidth * tmpHeight);
+        const Pel* src = reco.buf + (y0 - planes.ext - (halfFilterSize - 1)) * reco.stride - planes.ext;
+        const Pel* mid = tmp.data() + (halfFilterSize - 1) * planeWidth;
+
+        for (int fx = 0; fx < 4; fx++) {
+            m_if.filterHor(COMPONENT_Y, src, reco.stride, tmp.data(), planeWidth, planeWidth, tmpHeight,
+                           fx << MV_FRACTIONAL_BITS_DIFF, false, clpRng, InterpolationFilter::Filter::DEFAULT);
+            for (int fy = 0; fy < 4; fy++) {
+                if (fx == 0 && fy == 0) {
+                    continue;
+                }
+                Pel* dst = planes.samples[fy][fx].data() + (size_t)y0 * planeWidth;
+                m_if.filterVer(COMPONENT_Y, mid, planeWidth, dst, planeWidth, planeWidth, bandHeight,
+                               fy << MV_FRACTIONAL_BITS_DIFF, false, true, clpRng, InterpolationFilter::Filter::DEFAULT);
+            }
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(numBands, buildBand);
+    } else {
+        for (int band = 0; band < numBands; band++) {
+            buildBand(band);
+        }
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef __SUB_PEL_PLANES_H__
+#define __SUB_PEL_PLANES_H__
+
+#include "CommonLib/Picture.h"
+#include "CommonLib/InterpolationFilter.h"
+#include "WorkerPool.h"
+#include <list>
+#include <vector>
+
+namespace CAROL {
+
+// Planos de luma interpolados nas 15 fases fracionárias (1/4 de amostra) de cada referência,
+// construídos uma vez por imagem com o mesmo filtro em dois estágios do xExtDIFUpSamplingH/Q
+// (filterHor intermediário + filterVer final), logo com amostras idênticas às do refinamento por CU.
+// O número de referências em memória é limitado (LRU): cada uma ocupa ~15x a luma com margem.
+class SubPelPlanes {
+public:
+    struct Planes {
+        const Picture*   pic     = nullptr;
+        int              poc     = 0;
+        int              layerId = 0;
+        int              ext     = 0;        // extensão além da imagem coberta pelos planos
+        int              width   = 0;        // largura/altura da imagem
+        int              height  = 0;
+        ptrdiff_t        stride  = 0;
+        std::vector<Pel> samples[4][4];      // [fy][fx]; [0][0] vazio (usa a reconstrução)
+
+        // Amostra na posição (x + fx/4, y + fy/4) em coordenadas de luma da imagem
+        const Pel* at(int fx, int fy, int x, int y, ptrdiff_t& outStride) const {
+            if (fx == 0 && fy == 0) {
+                const CPelBuf reco = pic->getRecoBuf().Y();
+                outStride = reco.stride;
+                return reco.buf + y * reco.stride + x;
+            }
+            outStride = stride;
+            return samples[fy][fx].data() + (y + ext) * stride + (x + ext);
+        }
+
+        // A área [x, x + w) x [y, y + h) está dentro dos planos
+        bool contains(int x, int y, int w, int h) const {
+            return x >= -ext && y >= -ext && x + w <= width + ext && y + h <= height + ext;
+        }
+    };
+
+    SubPelPlanes() { m_if.initInterpolationFilter(true); }
+
+    // Planos de ref (construídos no primeiro pedido, em faixas de linhas distribuídas no pool).
+    // Retorna nullptr se maxPictures <= 0.
+    const Planes* get(const Picture& ref, const ClpRng& clpRng, int maxPictures, WorkerPool* pool);
+
+private:
+    static const int BAND_HEIGHT = 64;
+
+    void xBuild(Planes& planes, const ClpRng& clpRng, WorkerPool* pool) const;
+
+    InterpolationFilter m_if;
+    std::list<Planes>   m_planes;   // mais recente na frente
+};
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef __SYMMETRIC_PRED_CACHE_H__
+#define __SYMMETRIC_PRED_CACHE_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CommonLib/Mv.h"
+#include <algorithm>
+#include <vector>
+
+namespace CAROL {
+
+// Predições de luma e distorções de uma busca SMVD (AMVP inicial, refinamento em diamante/cruz e
+// symmvdCheckBestMvp) de um PU. Os candidatos (mv, -mv) se repetem entre as rodadas e entre os pares
+// de MVP: o par já avaliado devolve a distorção direto e cada lado fracionário é interpolado uma vez.
+class SymmetricPredCache {
+public:
+    static const int MAX_PREDS = 16;   // por lista; a mais antiga é substituída
+    static const int MAX_COSTS = 64;
+
+    void begin(int width, int height) {
+        m_active   = true;
+        m_width    = width;
+        m_height   = height;
+        m_numCosts = 0;
+        m_nextCost = 0;
+        for (int l = 0; l < NUM_REF_PIC_LIST_01; l++) {
+            m_numPreds[l] = 0;
+            m_nextPred[l] = 0;
+        }
+    }
+    void end() { m_active = false; }
+    bool isActive() const { return m_active; }
+
+    // Ativa a cache durante a busca simétrica de um PU
+    class Scope {
+    public:
+        Scope(SymmetricPredCache& cache, bool enabled, int width, int height) : m_cache(enabled ? &cache : nullptr) {
+            if (m_cache) m_cache->begin(width, height);
+        }
+        ~Scope() { if (m_cache) m_cache->end(); }
+        Scope(const Scope&) = delete;
+        void operator=(const Scope&) = delete;
+
+    private:
+        SymmetricPredCache* m_cache;
+    };
+
+    // Predição interpolada da lista no vetor mv (já com clipMv), com stride igual à largura do PU; nullptr se ausente
+    const Pel* findPred(int list, const Mv& mv) const {
+        for (int i = 0; i < m_numPreds[list]; i++) {
+            if (m_preds[list][i].mv == mv) {
+                return m_preds[list][i].samples.data();
+            }
+        }
+        return nullptr;
+    }
+    void storePred(int list, const Mv& mv, const CPelBuf& pred) {
+        const int i = m_nextPred[list];
+        m_nextPred[list] = (i + 1) % MAX_PREDS;
+        if (m_numPreds[list] < MAX_PREDS) m_numPreds[list]++;
+
+        Pred& entry = m_preds[list][i];
+        entry.mv = mv;
+        entry.samples.resize((size_t)m_width * m_height);
+        for (int y = 0; y < m_height; y++) {
+            std::copy(pred.buf + y * pred.stride, pred.buf + y * pred.stride + m_width, entry.samples.data() + y * m_width);
+        }
+    }
+
+    // Distorção (sem bits de vetor) do par (mvA na lista curList, mvB na outra)
+    bool findCost(int curList, const Mv& mvA, const Mv& mvB, Distortion& cost) const {
+        for (int i = 0; i < m_numCosts; i++) {
+            const Cost& c = m_costs[i];
+            if (c.curList == curList && c.mvA == mvA && c.mvB == mvB) {
+                cost = c.dist;
+                return true;
+            }
+        }
+        return false;
+    }
+    void storeCost(int curList, const Mv& mvA, const Mv& mvB, Distortion cost) {
+        Cost& c    = m_costs[m_nextCost];
+        c.curList  = curList;
+        c.mvA      = mvA;
+        c.mvB      = mvB;
+        c.dist     = cost;
+        m_nextCost = (m_nextCost + 1) % MAX_COSTS;
+        if (m_numCosts < MAX_COSTS) m_numCosts++;
+    }
+
+private:
+    struct Pred {
+        Mv               mv;
+        std::vector<Pel> samples;
+    };
+    struct Cost {
+        int        curList = 0;
+        Mv         mvA;
+        Mv         mvB;
+        Distortion dist = 0;
+    };
+
+    bool m_active   = false;
+    int  m_width    = 0;
+    int  m_height   = 0;
+    Pred m_preds[NUM_REF_PIC_LIST_01][MAX_PREDS];
+    int  m_numPreds[NUM_REF_PIC_LIST_01] = { 0 };
+    int  m_nextPred[NUM_REF_PIC_LIST_01] = { 0 };
+    Cost m_costs[MAX_COSTS];
+    int  m_numCosts = 0;
+    int  m_nextCost = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+#include "TZSadBatch.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if ENABLE_SIMD_OPT && !RExt__HIGH_BIT_DEPTH_SUPPORT
+#include <emmintrin.h>
+#endif
+
+namespace CAROL {
+
+void sadMultiCandidate(const CPelBuf& org, const Pel* const* cur, ptrdiff_t curStride, int numCand, int subShift,
+                       Distortion* sad) {
+    const int rowStep = 1 << subShift;
+    const int width   = org.width;
+    int       x0      = 0;
+
+#if ENABLE_SIMD_OPT && !RExt__HIGH_BIT_DEPTH_SUPPORT
+    // Pel de 16 bits: |org - cur| cabe em int16 e o madd com 1 acumula pares em int32
+    const int simdWidth = width & ~3;
+    if (simdWidth > 0) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one  = _mm_set1_epi16(1);
+        __m128i acc[TZSadBatch::GROUP_SIZE];
+        for (int c = 0; c < numCand; c++) {
+            acc[c] = zero;
+        }
+
+        for (int y = 0; y < org.height; y += rowStep) {
+            const Pel*      o   = org.buf + y * org.stride;
+            const ptrdiff_t off = y * curStride;
+            int x = 0;
+            for (; x + 8 <= simdWidth; x += 8) {
+                const __m128i vo = _mm_loadu_si128((const __m128i*)(o + x));
+                for (int c = 0; c < numCand; c++) {
+                    const __m128i d = _mm_sub_epi16(vo, _mm_loadu_si128((const __m128i*)(cur[c] + off + x)));
+                    acc[c] = _mm_add_epi32(acc[c], _mm_madd_epi16(_mm_max_epi16(d, _mm_sub_epi16(zero, d)), one));
+                }
+            }
+            if (x < simdWidth) {
+                const __m128i vo = _mm_loadl_epi64((const __m128i*)(o + x));
+                for (int c = 0; c < numCand; c++) {
+                    const __m128i d = _mm_sub_epi16(vo, _mm_loadl_epi64((const __m128i*)(cur[c] + off + x)));
+                    acc[c] = _mm_add_epi32(acc[c], _mm_madd_epi16(_mm_max_epi16(d, _mm_sub_epi16(zero, d)), one));
+                }
+            }
+        }
+
+        for (int c = 0; c < numCand; c++) {
+            __m128i s = _mm_add_epi32(acc[c], _mm_shuffle_epi32(acc[c], 0x4e));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+            sad[c] = (Distortion)(uint32_t)_mm_cvtsi128_si32(s);
+        }
+        x0 = simdWidth;
+    } else
+#endif
+    {
+        for (int c = 0; c < numCand; c++) {
+            sad[c] = 0;
+        }
+    }
+
+    if (x0 < width) {
+        for (int y = 0; y < org.height; y += rowStep) {
+            const Pel*      o   = org.buf + y * org.stride;
+            const ptrdiff_t off = y * curStride;
+            for (int c = 0; c < numCand; c++) {
+                const Pel* r = cur[c] + off;
+                for (int x = x0; x < width; x++) {
+                    sad[c] += std::abs(o[x] - r[x]);
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < numCand; c++) {
+        sad[c] <<= subShift;
+    }
+}
+
+void TZSadBatch::evaluate(const CPelBuf& org, const Pel* ref, ptrdiff_t refStride, int subShift, int bitDepth) {
+    for (int i0 = 0; i0 < m_num; i0 += GROUP_SIZE) {
+        const int  numCand = std::min(GROUP_SIZE, m_num - i0);
+        const Pel* cur[GROUP_SIZE];
+        for (int c = 0; c < numCand; c++) {
+            cur[c] = ref + m_y[i0 + c] * refStride + m_x[i0 + c];
+        }
+        sadMultiCandidate(org, cur, refStride, numCand, subShift, m_sad + i0);
+        for (int c = 0; c < numCand; c++) {
+            m_sad[i0 + c] >>= DISTORTION_PRECISION_ADJUSTMENT(bitDepth);
+        }
+    }
+    m_next   = 0;
+    m_filled = true;
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef __TZ_SAD_BATCH_H__
+#define __TZ_SAD_BATCH_H__
+
+#include "CommonLib/CommonDef.h"
+#include "CommonLib/Buffer.h"
+#include <cstdint>
+
+namespace CAROL {
+
+// SAD de um mesmo bloco original contra numCand (<= TZSadBatch::GROUP_SIZE) posições da referência:
+// cada linha do original é carregada uma vez e comparada com a mesma linha de todos os candidatos.
+// Só as linhas múltiplas de 1 << subShift entram, e o resultado tem a escala de RdCost::xGetSAD
+// (sem o ajuste DISTORTION_PRECISION_ADJUSTMENT).
+void sadMultiCandidate(const CPelBuf& org, const Pel* const* cur, ptrdiff_t curStride, int numCand, int subShift,
+                       Distortion* sad);
+
+// Pontos de um padrão do TZ (quadrado, diamante), avaliados de uma vez em grupos de GROUP_SIZE.
+// O xTZSearchHelp consome os SADs na mesma ordem em que os pontos foram adicionados.
+class TZSadBatch {
+public:
+    static const int MAX_CANDIDATES = 16;   // o diamante com iDist > 8 tem 16 pontos
+    static const int GROUP_SIZE     = 8;
+
+    void clear() {
+        m_num    = 0;
+        m_next   = 0;
+        m_filled = false;
+    }
+    void add(int x, int y, uint8_t pointNr, uint32_t distance) {
+        m_x[m_num]        = x;
+        m_y[m_num]        = y;
+        m_pointNr[m_num]  = pointNr;
+        m_distance[m_num] = distance;
+        m_num++;
+    }
+
+    int      size()          const { return m_num; }
+    int      x(int i)        const { return m_x[i]; }
+    int      y(int i)        const { return m_y[i]; }
+    uint8_t  pointNr(int i)  const { return m_pointNr[i]; }
+    uint32_t distance(int i) const { return m_distance[i]; }
+
+    // SADs de todos os pontos; ref aponta para o vetor (0, 0) da referência
+    void evaluate(const CPelBuf& org, const Pel* ref, ptrdiff_t refStride, int subShift, int bitDepth);
+
+    // Próximo SAD do lote, se (x, y) é o próximo ponto avaliado
+    bool take(int x, int y, Distortion& sad) {
+        if (!m_filled || m_next >= m_num || m_x[m_next] != x || m_y[m_next] != y) {
+            return false;
+        }
+        sad = m_sad[m_next++];
+        return true;
+    }
+
+private:
+    int        m_num    = 0;
+    int        m_next   = 0;
+    bool       m_filled = false;
+    int        m_x[MAX_CANDIDATES];
+    int        m_y[MAX_CANDIDATES];
+    uint8_t    m_pointNr[MAX_CANDIDATES];
+    uint32_t   m_distance[MAX_CANDIDATES];
+    Distortion m_sad[MAX_CANDIDATES];
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "WorkerPool.h"
+
+namespace CAROL {
+
+WorkerPool::WorkerPool(int numThreads) {
+    for (int i = 1; i < numThreads; i++) {
+        m_workers.emplace_back(&WorkerPool::xWorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_taskCond.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+// Pega o próximo índice do lote e o executa fora do lock; retorna false se não há tarefa pendente
+bool WorkerPool::xRunNextTask(std::unique_lock<std::mutex>& lock) {
+    if (m_func == nullptr || m_nextTask >= m_numTasks) {
+        return false;
+    }
+    const std::function<void(int)>& func = *m_func;
+    const int task = m_nextTask++;
+    m_running++;
+
+    lock.unlock();
+    func(task);
+    lock.lock();
+
+    if (--m_running == 0 && m_nextTask >= m_numTasks) {
+        m_doneCond.notify_all();
+    }
+    return true;
+}
+
+void WorkerPool::xWorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_taskCond.wait(lock, [this] { return m_stop || (m_func != nullptr && m_nextTask < m_numTasks); });
+        if (m_stop) {
+            return;
+        }
+        xRunNextTask(lock);
+    }
+}
+
+void WorkerPool::parallelFor(int numTasks, const std::function<void(int)>& func) {
+    if (numTasks <= 0) {
+        return;
+    }
+    if (m_workers.empty() || numTasks == 1) {
+        for (int i = 0; i < numTasks; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_func     = &func;
+    m_numTasks = numTasks;
+    m_nextTask = 0;
+    m_running  = 0;
+    m_taskCond.notify_all();
+
+    // a thread chamadora também consome tarefas
+    while (xRunNextTask(lock)) {
+    }
+    m_doneCond.wait(lock, [this] { return m_running == 0 && m_nextTask >= m_numTasks; });
+    m_func = nullptr;
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CAROL {
+
+// Conjunto fixo de threads auxiliares para tarefas independentes de um mesmo encoder.
+// parallelFor distribui os índices entre as auxiliares e a thread chamadora e só retorna
+// quando todos terminarem; a ordem de execução não é determinística, então cada tarefa
+// deve escrever apenas no seu próprio resultado.
+class WorkerPool {
+public:
+    explicit WorkerPool(int numThreads);
+    ~WorkerPool();
+
+    // Executa func(i) para i em [0, numTasks)
+    void parallelFor(int numTasks, const std::function<void(int)>& func);
+
+    int getNumThreads() const { return (int)m_workers.size() + 1; }
+
+    WorkerPool(const WorkerPool&) = delete;
+    void operator=(const WorkerPool&) = delete;
+
+private:
+    void xWorkerLoop();
+    bool xRunNextTask(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread>         m_workers;
+    std::mutex                       m_mutex;
+    std::condition_variable          m_taskCond;   // novas tarefas ou encerramento
+    std::condition_variable          m_doneCond;   // todas as tarefas do lote concluídas
+    const std::function<void(int)>*  m_func     = nullptr;
+    int                              m_numTasks = 0;
+    int                              m_nextTask = 0;
+    int                              m_running  = 0;
+    bool                             m_stop     = false;
+};
+
+}
+
+#endif
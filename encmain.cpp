@@ -42,8 +42,19 @@
 
 #include "EncoderLib/EncLibCommon.h"
 #include "EncApp.h"
+#include "EncoderLib/SpeedupStats.h"
+#include "EncoderLib/HotPathProfiler.h"
+#include "EncoderLib/BlockHistogram.h"
+#include "EncoderLib/CtuScope.h"
+#include "EncoderLib/OrgFeatureCache.h"
 #include "Utilities/program_options_lite.h"
 
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
 //! \ingroup EncoderApp
 //! \{
 
@@ -101,6 +112,288 @@ int getProcStatusValue(const char* key)
 }
 #endif
 
+// ====================================================================================================================
+// CAROL: setup and teardown shared by main() and the multi-QP mode
+// ====================================================================================================================
+
+// Cria o codificador e lê a configuração. O EncApp fica em encApp mesmo quando a leitura falha (mensagem já
+// impressa), para o chamador destruí-lo no seu único caminho de limpeza.
+static bool CAROL_createEncApp(EncApp*& encApp, std::fstream& bitstream, EncLibCommon* encLibCommon, int argc,
+                               char* argv[])
+{
+  encApp = new EncApp(bitstream, encLibCommon);
+  encApp->create();
+  try
+  {
+    return encApp->parseCfg(argc, argv);
+  }
+  catch (ProgramOptionsLite::ParseFailure& e)
+  {
+    std::cerr << "Error parsing option \"" << e.arg << "\" with argument \"" << e.val << "\"." << std::endl;
+    return false;
+  }
+}
+
+// Destrói os codificadores criados (a biblioteca só dos numLibs primeiros, que passaram pelo createLib) e a ROM
+static void CAROL_destroyEncApps(std::vector<EncApp*>& encApps, size_t numLibs)
+{
+  for (size_t i = 0; i < encApps.size(); i++)
+  {
+    if (encApps[i] == nullptr)
+    {
+      continue;
+    }
+    if (i < numLibs)
+    {
+      encApps[i]->destroyLib();
+    }
+    // destroy application encoder class per layer
+    encApps[i]->destroy();
+    delete encApps[i];
+  }
+  encApps.clear();
+
+  // destroy ROM
+  destroyROM();
+}
+
+// Executa um passo do encode (encodePrep/encode); false se o codificador lançou exceção (mensagem já impressa)
+template<typename Step> static bool CAROL_runEncodeStep(Step step)
+{
+#ifndef _DEBUG
+  try
+  {
+#endif
+    step();
+#ifndef _DEBUG
+  }
+  catch (Exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  catch (const std::bad_alloc& e)
+  {
+    std::cout << "Memory allocation failed: " << e.what() << std::endl;
+    return false;
+  }
+#endif
+  return true;
+}
+
+// starting time
+static void CAROL_startTimer(std::chrono::steady_clock::time_point& startTime, clock_t& startClock)
+{
+  startTime              = std::chrono::steady_clock::now();
+  std::time_t startTime2 = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  fprintf(stdout, " started @ %s", std::ctime(&startTime2));
+  startClock = clock();
+}
+
+static void CAROL_printMemoryUsage()
+{
+#ifdef __linux
+  int vm = getProcStatusValue("VmPeak:");
+  int rm = getProcStatusValue("VmHWM:");
+  printf("\nMemory Usage: VmPeak= %d KB ( %.1f GiB ),  VmHWM= %d KB ( %.1f GiB )\n", vm, (double)vm/(1024*1024), rm, (double)rm/(1024*1024));
+#endif
+}
+
+// Relatórios do fim do encode; os arquivos de saída são lidos do primeiro codificador antes da destruição
+static void CAROL_printReports(const std::string& profileJsonFile, const std::string& histogramFile)
+{
+  CAROL::SpeedupStats::getInstance().report(stdout);
+#if CAROL_PROFILING
+  CAROL::HotPathProfiler::report(stdout);
+  CAROL::HotPathProfiler::writeJson(profileJsonFile);
+  CAROL::BlockHistogram::write(histogramFile);
+#else
+  (void) profileJsonFile;
+  (void) histogramFile;
+#endif
+}
+
+// ====================================================================================================================
+// CAROL: multi-QP mode
+// ====================================================================================================================
+
+static const char   CAROL_QP_LIST_OPTION[]         = "--CAROLQPs=";
+static const size_t CAROL_MULTI_QP_FEATURE_ENTRIES = 1 << 21;   // ~700 MB de features do original em memória
+
+// QPs de --CAROLQPs=22,27,32,37 (vazio fora do modo multi-QP); false, com a mensagem impressa, se algum QP
+// não é um inteiro
+static bool CAROL_parseQpList(int argc, char* argv[], std::vector<int>& qps)
+{
+  qps.clear();
+  const size_t prefixLen = strlen(CAROL_QP_LIST_OPTION);
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], CAROL_QP_LIST_OPTION, prefixLen) == 0)
+    {
+      qps.clear();
+      std::stringstream list(argv[i] + prefixLen);
+      std::string       qp;
+      while (std::getline(list, qp, ','))
+      {
+        if (qp.empty())
+        {
+          continue;
+        }
+        try
+        {
+          size_t    parsed = 0;
+          const int value  = std::stoi(qp, &parsed);
+          if (parsed != qp.size())
+          {
+            throw std::invalid_argument(qp);
+          }
+          qps.push_back(value);
+        }
+        catch (const std::logic_error&)   // std::invalid_argument e std::out_of_range
+        {
+          std::cerr << "Error parsing option \"" << argv[i] << "\": invalid QP \"" << qp << "\"." << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Um EncLib por QP no mesmo processo, com bitstream, reconstrução e CSVs próprios (sufixo _qpN). Os
+// codificadores avançam um GOP de cada vez, em sequência: as features do original calculadas pelo primeiro
+// QP ficam na OrgFeatureCache para os demais (exceto com o filtro temporal do GOP, que filtra o original
+// conforme o QP), e os caches de CTU distinguem os codificadores pelo CtuTag::currentInstance(). Só para uma camada.
+static int CAROL_encodeMultiQp(int argc, char* argv[], const std::vector<int>& qps)
+{
+  const int numQps = (int) qps.size();
+
+  std::vector<char*> commonArgv;
+  for (int i = 0; i < argc; i++)
+  {
+    if (argv[i][0] == '-' && argv[i][1] == 'l')
+    {
+      std::cerr << "CAROLQPs: multi-layer encoding is not supported in multi-QP mode" << std::endl;
+      return 1;
+    }
+    if (strncmp(argv[i], CAROL_QP_LIST_OPTION, strlen(CAROL_QP_LIST_OPTION)) != 0)
+    {
+      commonArgv.push_back(argv[i]);
+    }
+  }
+
+  initROM();
+
+  // os EncLibCommon e bitstreams vivem até depois do CAROL_destroyEncApps
+  std::vector<std::unique_ptr<std::fstream>> bitstreams;
+  std::vector<std::unique_ptr<EncLibCommon>> encLibCommons;
+  std::vector<EncApp*>                       encApps(numQps, nullptr);
+  size_t                                     numLibs = 0;
+
+  bool ok = true;
+  for (int q = 0; q < numQps && ok; q++)
+  {
+    CAROL::CtuTag::currentInstance() = q;
+    bitstreams.emplace_back(new std::fstream);
+    encLibCommons.emplace_back(new EncLibCommon);
+
+    // o --QP no fim prevalece sobre o dos arquivos de configuração
+    std::string        qpArg = "--QP=" + std::to_string(qps[q]);
+    std::vector<char*> qpArgv(commonArgv);
+    qpArgv.push_back(&qpArg[0]);
+    ok = CAROL_createEncApp(encApps[q], *bitstreams.back(), encLibCommons.back().get(), (int) qpArgv.size(),
+                            qpArgv.data());
+    if (ok && encApps[q]->getMaxLayers() > 1)
+    {
+      std::cerr << "CAROLQPs: multi-layer encoding is not supported in multi-QP mode" << std::endl;
+      ok = false;
+    }
+    if (ok)
+    {
+      encApps[q]->CAROL_addOutputSuffix("_qp" + std::to_string(qps[q]));
+      encApps[q]->createLib(0);
+      numLibs++;
+      encApps[q]->CAROL_getEncLib()->CAROL_setInputFileName(encApps[q]->CAROL_getInputFileName());
+      encApps[q]->CAROL_initSpeedupCfg();
+    }
+  }
+  if (!ok)
+  {
+    CAROL_destroyEncApps(encApps, numLibs);
+    return 1;
+  }
+
+  CAROL::OrgFeatureCache::getInstance().setMaxEntries(CAROL_MULTI_QP_FEATURE_ENTRIES);
+
+  std::chrono::steady_clock::time_point startTime;
+  clock_t                               startClock;
+  CAROL_startTimer(startTime, startClock);
+
+  std::vector<bool> eos(numQps, false);
+  int               numActive = numQps;
+  while (numActive > 0 && ok)
+  {
+    for (int q = 0; q < numQps && ok; q++)
+    {
+      if (eos[q])
+      {
+        continue;
+      }
+      CAROL::CtuTag::currentInstance() = q;
+      bool instanceEos                 = false;
+      // lê e codifica um GOP deste QP
+      ok = CAROL_runEncodeStep([&] {
+        bool keepLoop = true;
+        while (keepLoop)
+        {
+          keepLoop = encApps[q]->encodePrep(instanceEos);
+        }
+        keepLoop = true;
+        while (keepLoop)
+        {
+          keepLoop = encApps[q]->encode();
+        }
+      });
+      if (instanceEos)
+      {
+        eos[q] = true;
+        numActive--;
+      }
+    }
+  }
+  if (!ok)
+  {
+    CAROL_destroyEncApps(encApps, numLibs);
+    return EXIT_FAILURE;
+  }
+  for (int q = 0; q < numQps; q++)
+  {
+    if (encApps[q]->getNNPostFilterEnabled())
+    {
+      CAROL::CtuTag::currentInstance() = q;
+      encApps[q]->applyNnPostFilter();
+    }
+  }
+
+  CAROL_printMemoryUsage();
+
+  clock_t     endClock = clock();
+  auto        endTime  = std::chrono::steady_clock::now();
+  std::time_t endTime2 = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  auto        encTime  = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+
+  const std::string profileJsonFile = encApps[0]->CAROL_getProfileJsonFile();
+  const std::string histogramFile   = encApps[0]->CAROL_getHistogramFile();
+  CAROL_destroyEncApps(encApps, numLibs);
+
+  printf("\n finished @ %s", std::ctime(&endTime2));
+  printf(" Total Time (%d QPs): %12.3f sec. [user] %12.3f sec. [elapsed]\n", numQps,
+         (endClock - startClock) * 1.0 / CLOCKS_PER_SEC, encTime / 1000.0);
+  CAROL_printReports(profileJsonFile, histogramFile);
+
+  return 0;
+}
+
 // ====================================================================================================================
 // Main function
 // ====================================================================================================================
@@ -126,10 +419,20 @@ int main(int argc, char* argv[])
 #endif
   fprintf( stdout, "\n" );
 
+  std::vector<int> carolQps;
+  if (!CAROL_parseQpList(argc, argv, carolQps))
+  {
+    return 1;
+  }
+  if (!carolQps.empty())
+  {
+    return CAROL_encodeMultiQp(argc, argv, carolQps);
+  }
+
   std::fstream bitstream;
   EncLibCommon encLibCommon;
 
-  std::vector<EncApp*> pcEncApp(1);
+  std::vector<EncApp*> pcEncApp(1, nullptr);
   bool resized = false;
   int layerIdx = 0;
 
@@ -139,62 +442,52 @@ int main(int argc, char* argv[])
 
   do
   {
-    pcEncApp[layerIdx] = new EncApp( bitstream, &encLibCommon );
-    // create application encoder class per layer
-    pcEncApp[layerIdx]->create();
-
     // parse configuration per layer
-    try
+    int j = 0;
+    for( int i = 0; i < argc; i++ )
     {
-      int j = 0;
-      for( int i = 0; i < argc; i++ )
+      if( argv[i][0] == '-' && argv[i][1] == 'l' )
       {
-        if( argv[i][0] == '-' && argv[i][1] == 'l' )
+        if (argc <= i + 1)
+        {
+          THROW("Command line parsing error: missing parameter after -lx\n");
+        }
+        int numParams = 1; // count how many parameters are consumed
+        // check for long parameters, which start with "--"
+        const std::string param = argv[i + 1];
+        if (param.rfind("--", 0) != 0)
         {
-          if (argc <= i + 1)
+          // only short parameters have a second parameter for the value
+          if (argc <= i + 2)
           {
             THROW("Command line parsing error: missing parameter after -lx\n");
           }
-          int numParams = 1; // count how many parameters are consumed
-          // check for long parameters, which start with "--"
-          const std::string param = argv[i + 1];
-          if (param.rfind("--", 0) != 0)
-          {
-            // only short parameters have a second parameter for the value
-            if (argc <= i + 2)
-            {
-              THROW("Command line parsing error: missing parameter after -lx\n");
-            }
-            numParams++;
-          }
-          // check if correct layer index
-          if( argv[i][2] == std::to_string( layerIdx ).c_str()[0] )
-          {
-            layerArgv[j] = argv[i + 1];
-            if (numParams > 1)
-            {
-              layerArgv[j + 1] = argv[i + 2];
-            }
-            j+= numParams;
-          }
-          i += numParams;
+          numParams++;
         }
-        else
+        // check if correct layer index
+        if( argv[i][2] == std::to_string( layerIdx ).c_str()[0] )
         {
-          layerArgv[j] = argv[i];
-          j++;
+          layerArgv[j] = argv[i + 1];
+          if (numParams > 1)
+          {
+            layerArgv[j + 1] = argv[i + 2];
+          }
+          j+= numParams;
         }
+        i += numParams;
       }
-
-      if( !pcEncApp[layerIdx]->parseCfg( j, layerArgv ) )
+      else
       {
-        pcEncApp[layerIdx]->destroy();
-        return 1;
+        layerArgv[j] = argv[i];
+        j++;
       }
     }
-    catch (ProgramOptionsLite::ParseFailure& e)
+
+    // create application encoder class per layer
+    if (!CAROL_createEncApp(pcEncApp[layerIdx], bitstream, &encLibCommon, j, layerArgv))
     {
-      std::cerr << "Error parsing option \"" << e.arg << "\" with argument \"" << e.val << "\"." << std::endl;
+      delete[] layerArgv;
+      CAROL_destroyEncApps(pcEncApp, layerIdx);
       return 1;
     }
 
@@ -278,72 +571,46 @@ int main(int argc, char* argv[])
   printMacroSettings();
 #endif
 
-  // starting time
-  auto startTime  = std::chrono::steady_clock::now();
-  std::time_t startTime2 = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-  fprintf(stdout, " started @ %s", std::ctime(&startTime2) );
-  clock_t startClock = clock();
+  std::chrono::steady_clock::time_point startTime;
+  clock_t                               startClock;
+  CAROL_startTimer(startTime, startClock);
 
   // call encoding function per layer
   bool eos = false;
   pcEncApp[0]->CAROL_getEncLib()->CAROL_setInputFileName(pcEncApp[0]->CAROL_getInputFileName());
+  for( auto & encApp : pcEncApp )
+  {
+    encApp->CAROL_initSpeedupCfg();
+  }
 
-  while( !eos )
+  bool ok = true;
+  while( !eos && ok )
   {
     // read GOP
     bool keepLoop = true;
-    while( keepLoop )
+    while( keepLoop && ok )
     {
       for( auto & encApp : pcEncApp )
       {
-#ifndef _DEBUG
-        try
-        {
-#endif
-          keepLoop = encApp->encodePrep( eos );
-#ifndef _DEBUG
-        }
-        catch( Exception &e )
-        {
-          std::cerr << e.what() << std::endl;
-          return EXIT_FAILURE;
-        }
-        catch( const std::bad_alloc &e )
-        {
-          std::cout << "Memory allocation failed: " << e.what() << std::endl;
-          return EXIT_FAILURE;
-        }
-#endif
+        ok = ok && CAROL_runEncodeStep([&] { keepLoop = encApp->encodePrep( eos ); });
       }
     }
 
     // encode GOP
     keepLoop = true;
-    while( keepLoop )
+    while( keepLoop && ok )
     {
       for( auto & encApp : pcEncApp )
       {
-#ifndef _DEBUG
-        try
-        {
-#endif
-          keepLoop = encApp->encode();
-#ifndef _DEBUG
-        }
-        catch( Exception &e )
-        {
-          std::cerr << e.what() << std::endl;
-          return EXIT_FAILURE;
-        }
-        catch( const std::bad_alloc &e )
-        {
-          std::cout << "Memory allocation failed: " << e.what() << std::endl;
-          return EXIT_FAILURE;
-        }
-#endif
+        ok = ok && CAROL_runEncodeStep([&] { keepLoop = encApp->encode(); });
       }
     }
   }
+  if (!ok)
+  {
+    CAROL_destroyEncApps(pcEncApp, pcEncApp.size());
+    return EXIT_FAILURE;
+  }
   for( auto & encApp : pcEncApp )
   {
     if (encApp->getNNPostFilterEnabled())
@@ -352,11 +619,7 @@ int main(int argc, char* argv[])
     }
   }
 
-#ifdef __linux
-  int vm = getProcStatusValue("VmPeak:");
-  int rm = getProcStatusValue("VmHWM:");
-  printf("\nMemory Usage: VmPeak= %d KB ( %.1f GiB ),  VmHWM= %d KB ( %.1f GiB )\n", vm, (double)vm/(1024*1024), rm, (double)rm/(1024*1024));
-#endif
+  CAROL_printMemoryUsage();
 
   // ending time
   clock_t endClock = clock();
@@ -384,20 +647,9 @@ int main(int argc, char* argv[])
     writeGMFAOutput(featureCounterFinal, dummy, encApp->getGMFAFile(),true);
   }
 #endif
-  for( auto & encApp : pcEncApp )
-  {
-    encApp->destroyLib();
-
-    // destroy application encoder class per layer
-    encApp->destroy();
-
-    delete encApp;
-  }
-
-  // destroy ROM
-  destroyROM();
-
-  pcEncApp.clear();
+  const std::string profileJsonFile = pcEncApp[0]->CAROL_getProfileJsonFile();
+  const std::string histogramFile   = pcEncApp[0]->CAROL_getHistogramFile();
+  CAROL_destroyEncApps(pcEncApp, pcEncApp.size());
 
   printf( "\n finished @ %s", std::ctime(&endTime2) );
 
@@ -412,6 +664,7 @@ int main(int argc, char* argv[])
          (endClock - startClock) * 1.0 / CLOCKS_PER_SEC,
          encTime / 1000.0);
 #endif
+  CAROL_printReports(profileJsonFile, histogramFile);
 
   return 0;
 }